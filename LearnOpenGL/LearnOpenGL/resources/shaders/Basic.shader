@@ -1,31 +1,114 @@
 #SHADER VERTEX
 #version 460 core
 
+#include "include/Camera.glsl"
+
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec2 texCoord;
+#ifdef INSTANCED
+layout(location = 2) in mat4 a_Model;
+#elif defined(MULTI_DRAW)
+// RenderQueue multi draws, one record per draw
+struct DrawRecord
+{
+	mat4 Model;
+	uint Material;
+};
+layout(std430) readonly buffer DrawData
+{
+	DrawRecord u_Draws[];
+};
+#else
+uniform mat4 u_Model;
+#endif
 
-out vec2 v_TexCoord;
+// ATLAS samples the cube's image out of a TextureAtlas page, min uv in xy, max uv in zw
+#if defined(ATLAS) && defined(INSTANCED)
+layout(std430) readonly buffer AtlasRegions
+{
+	vec4 u_AtlasRegions[];
+};
+#elif defined(ATLAS)
+uniform vec4 u_AtlasRegion;
+#endif
 
-uniform mat4 u_MVP;
+// TEXTURE_TABLE picks the cube's texture out of a TextureTable by index
+#if defined(TEXTURE_TABLE) && defined(INSTANCED)
+layout(std430) readonly buffer InstanceTextures
+{
+	uint u_InstanceTextures[];
+};
+#elif defined(TEXTURE_TABLE) && !defined(MULTI_DRAW)
+uniform int u_TextureIndex;
+#endif
+
+out vec2 v_TexCoord;
+#ifdef TEXTURE_TABLE
+flat out uint v_TextureIndex;
+#endif
 
 void main()
 {
-	gl_Position = u_MVP * vec4(position, 1.0);
+#ifdef INSTANCED
+	mat4 model = a_Model;
+#elif defined(MULTI_DRAW)
+	// the queue numbers records through baseInstance, gl_DrawID restarts with every multi draw call
+	uint draw = uint(gl_BaseInstance + gl_InstanceID);
+	mat4 model = u_Draws[draw].Model;
+#else
+	mat4 model = u_Model;
+#endif
+	gl_Position = u_ViewProjection * model * vec4(position, 1.0);
+#if defined(ATLAS) && defined(INSTANCED)
+	vec4 region = u_AtlasRegions[gl_InstanceID];
+	v_TexCoord = mix(region.xy, region.zw, texCoord);
+#elif defined(ATLAS)
+	v_TexCoord = mix(u_AtlasRegion.xy, u_AtlasRegion.zw, texCoord);
+#else
 	v_TexCoord = texCoord;
+#endif
+#if defined(TEXTURE_TABLE) && defined(INSTANCED)
+	v_TextureIndex = u_InstanceTextures[gl_InstanceID];
+#elif defined(TEXTURE_TABLE) && defined(MULTI_DRAW)
+	v_TextureIndex = u_Draws[draw].Material;
+#elif defined(TEXTURE_TABLE)
+	v_TextureIndex = uint(u_TextureIndex);
+#endif
 }
 
 
 #SHADER FRAGMENT
 #version 460 core
+#ifdef BINDLESS
+#extension GL_ARB_bindless_texture : require
+#endif
 
 layout(location = 0) out vec4 color;
 
 in vec2 v_TexCoord;
 
+#if defined(TEXTURE_TABLE) && defined(BINDLESS)
+layout(std430) readonly buffer TextureHandles
+{
+	uvec2 u_TextureHandles[];
+};
+#elif defined(TEXTURE_TABLE)
+uniform sampler2DArray u_TextureArray;
+#else
 uniform sampler2D u_Texture;
+#endif
+#ifdef TEXTURE_TABLE
+flat in uint v_TextureIndex;
+#endif
 
 void main()
 {
+#if defined(TEXTURE_TABLE) && defined(BINDLESS)
+	vec4 texColor = texture(sampler2D(u_TextureHandles[v_TextureIndex]), v_TexCoord);
+#elif defined(TEXTURE_TABLE)
+	vec4 texColor = texture(u_TextureArray, vec3(v_TexCoord, float(v_TextureIndex)));
+#else
 	vec4 texColor = texture(u_Texture, v_TexCoord);
+#endif
 	color = texColor;
 }
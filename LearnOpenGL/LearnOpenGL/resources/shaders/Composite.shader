@@ -0,0 +1,23 @@
+#SHADER VERTEX
+#version 460 core
+
+// one triangle that covers the screen, no vertex buffer
+void main()
+{
+	vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
+
+
+#SHADER FRAGMENT
+#version 460 core
+
+layout(location = 0) out vec4 color;
+
+// premultiplied, the same size as the target it's drawn onto
+layout(binding = 0) uniform sampler2D u_Texture;
+
+void main()
+{
+	color = texelFetch(u_Texture, ivec2(gl_FragCoord.xy), 0);
+}
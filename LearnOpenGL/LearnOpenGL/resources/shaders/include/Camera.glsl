@@ -0,0 +1,13 @@
+#ifndef CAMERA_GLSL
+#define CAMERA_GLSL
+
+// Per-frame camera, uploaded once by Renderer::BeginScene (CameraBlock in UniformBlocks.h)
+layout(std140) uniform Camera
+{
+	mat4 u_View;
+	mat4 u_Projection;
+	mat4 u_ViewProjection;
+	float u_Time;
+};
+
+#endif
@@ -0,0 +1,951 @@
+#include "Benchmark.h"
+#include "Renderer.h"
+#include "CubeScene.h"
+#include "Framebuffer.h"
+#include "GLStateCache.h"
+#include "ProgramCache.h"
+#include "ShaderCompiler.h"
+#include "ShaderLibrary.h"
+#include "StreamBuffer.h"
+#include "TextureStreamer.h"
+#include "TextureCooker.h"
+#include "TextureAtlas.h"
+#include "TextureTable.h"
+#include "ResourceManager.h"
+#include "ResourceBackend.h"
+#include "UniformBuffer.h"
+#include "UniformBlocks.h"
+#include "VertexBufferLayout.h"
+#include "Cube.h"
+#include "Material.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+#include "imgui/imgui.h"
+#include "imgui/imgui_impl_glfw_gl3.h"
+
+// Build with BENCHMARK_ALLOCATIONS 1 (the Benchmark configuration does) to count heap
+// allocations per thread, so the uniforms benchmark can assert a path doesn't allocate. It
+// replaces the global allocator for the whole executable, which is why Debug and Release leave
+// it off. The array and nothrow forms end up in this
+// operator new too; aligned allocations aren't counted.
+#ifndef BENCHMARK_ALLOCATIONS
+	#define BENCHMARK_ALLOCATIONS 0
+#endif
+
+#if BENCHMARK_ALLOCATIONS
+static thread_local size_t s_Allocations = 0;
+
+void* operator new(size_t size)
+{
+	s_Allocations++;
+	if (void* memory = std::malloc(size)) { return memory; }
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+#else
+static const size_t s_Allocations = 0;
+#endif
+
+struct FrameTiming
+{
+	double CpuMs;	// time spent submitting
+	double FrameMs;	// submit + wait for the GPU to finish
+};
+
+struct Distribution
+{
+	double Mean, P50, P95, Max;
+};
+
+static Distribution Summarize(std::vector<double> samples)
+{
+	if (samples.empty()) { return { 0.0, 0.0, 0.0, 0.0 }; }
+
+	std::sort(samples.begin(), samples.end());
+	double sum = 0.0;
+	for (double sample : samples) { sum += sample; }
+	return { sum / samples.size(), samples[(samples.size() - 1) / 2],
+		samples[(size_t)((samples.size() - 1) * 0.95)], samples.back() };
+}
+
+// Ends the renderer's frame after every one so its stream buffer moves on, renderer can be
+// null when nothing draws through one
+template<typename F>
+static FrameTiming TimeFrames(GLFWwindow* window, Renderer* renderer, unsigned int frames, F drawFrame)
+{
+	using clock = std::chrono::high_resolution_clock;
+	double cpu = 0.0, total = 0.0;
+
+	for (unsigned int i = 0; i < frames; i++)
+	{
+		auto start = clock::now();
+		GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+		drawFrame();
+		if (renderer) { renderer->EndFrame(); }
+		auto submitted = clock::now();
+		GLCall(glFinish());
+		auto finished = clock::now();
+
+		cpu += std::chrono::duration<double, std::milli>(submitted - start).count();
+		total += std::chrono::duration<double, std::milli>(finished - start).count();
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+	}
+	return { cpu / frames, total / frames };
+}
+
+// Pulls a number out of one of our own flat JSON reports
+static bool ReadJsonNumber(const std::string& json, const std::string& key, double& value)
+{
+	size_t position = json.find("\"" + key + "\":");
+	if (position == std::string::npos) { return false; }
+
+	std::istringstream stream(json.substr(position + key.size() + 3));
+	return (bool)(stream >> value);
+}
+
+// Per-object loop (one bind, one uniform and one draw per cube) vs a single instanced draw
+static int BenchInstancing(GLFWwindow* window, const BenchmarkOptions& options)
+{
+	Renderer renderer;
+	ShaderCompiler compiler;
+	ShaderLibrary shaders(compiler);
+	ResourceManager resources(shaders);
+	glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -3.0f));
+	glm::mat4 projection = glm::perspective(45.0f, 800.0f / 600.0f, 0.1f, 10000.0f);
+
+	GLStateCache::Get().SetEnabled(GL_DEPTH_TEST, true);
+	renderer.BeginScene(view, projection, 0.0f);
+	std::cout << "instances\tloop cpu ms\tloop frame ms\tinstanced cpu ms\tinstanced frame ms\n";
+
+	const unsigned int counts[] = { 10, 10000, 1000000 };
+	for (unsigned int count : counts)
+	{
+		CubeScene scene(resources, count);
+		scene.Update(0.0f);
+		unsigned int frames = count >= 1000000 ? 5 : 100;
+
+		FrameTiming loop = TimeFrames(window, &renderer, frames, [&]()
+		{
+			scene.Draw(renderer, CubeScene::DRAW_LOOP, view);
+		});
+
+		FrameTiming instanced = TimeFrames(window, &renderer, frames, [&]()
+		{
+			scene.Draw(renderer, CubeScene::DRAW_INSTANCED, view);
+		});
+
+		std::cout << count << "\t" << loop.CpuMs << "\t" << loop.FrameMs << "\t"
+			<< instanced.CpuMs << "\t" << instanced.FrameMs << std::endl;
+	}
+	// batches that didn't fit fell back to the orphaned instance VertexBuffer
+	std::cout << "stream buffer overflows\t" << renderer.GetStreamBuffer().GetStats().Overflows << std::endl;
+
+	return 0;
+}
+
+// Cost of one cheap GL call under each GLCall mode. The modes are normally picked at
+// compile time, so they are spelled out by hand here to compare them in one run.
+static int BenchGLCall(GLFWwindow* window, const BenchmarkOptions& options)
+{
+	using clock = std::chrono::high_resolution_clock;
+	const unsigned int calls = 1000000;
+
+	Shader shader("resources/shaders/Basic.shader");
+	shader.Bind();
+	GLCall(int location = glGetUniformLocation(shader.GetRendererID(), "u_Texture"));
+
+	auto measure = [&](const char* name, auto call)
+	{
+		auto start = clock::now();
+		for (unsigned int i = 0; i < calls; i++)
+		{
+			call(i);
+		}
+		GLCall(glFinish());
+		double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count() / calls;
+		std::cout << name << "\t" << ns << " ns/call" << std::endl;
+	};
+
+	std::cout << "mode\toverhead (glUniform1i x " << calls << ")\n";
+	measure("none", [&](unsigned int i)
+	{
+		glUniform1i(location, i & 1);
+	});
+	measure("async", [&](unsigned int i)
+	{
+		GLSetCallSite("glUniform1i(location, i & 1)", __FILE__, __LINE__);
+		glUniform1i(location, i & 1);
+	});
+	measure("sync", [&](unsigned int i)
+	{
+		GLSetCallSite("glUniform1i(location, i & 1)", __FILE__, __LINE__);
+		GLClearError();
+		glUniform1i(location, i & 1);
+		GLLogCall("glUniform1i(location, i & 1)", __FILE__, __LINE__);
+	});
+
+	return 0;
+}
+
+// Uniform updates through handles vs names vs a material upload, and proof that the
+// handle and material paths never allocate
+static int BenchUniforms(GLFWwindow* window, const BenchmarkOptions& options)
+{
+	using clock = std::chrono::high_resolution_clock;
+	static constexpr UniformHandle MODEL_UNIFORM("u_Model");
+	const unsigned int objects = 10000, frames = 100, warmup = 5;
+
+	Shader shader("resources/shaders/Basic.shader");
+	shader.Bind();
+	glm::mat4 model(1.0f);
+
+	auto measure = [&](const char* name, auto setUniform)
+	{
+		size_t allocations = 0;
+		auto start = clock::now();
+		for (unsigned int frame = 0; frame < warmup + frames; frame++)
+		{
+			if (frame == warmup)
+			{
+				start = clock::now();
+				allocations = s_Allocations;
+			}
+			for (unsigned int i = 0; i < objects; i++)
+			{
+				setUniform(model);
+			}
+		}
+		GLCall(glFinish());
+		allocations = s_Allocations - allocations;
+		double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count() / (objects * frames);
+		std::cout << name << "\t" << ns << " ns/call\t" << allocations << " allocations in " << frames << " steady-state frames" << std::endl;
+		return allocations;
+	};
+
+	measure("string", [&](const glm::mat4& matrix) { shader.SetUniformMat4f("u_Model", matrix); });
+	size_t handleAllocations = measure("handle", [&](const glm::mat4& matrix) { shader.SetUniformMat4f(MODEL_UNIFORM, matrix); });
+	Material material(shader);
+	material.Set(MODEL_UNIFORM, model);
+	size_t materialAllocations = measure("material", [&](const glm::mat4& matrix)
+	{
+		material.Set(MODEL_UNIFORM, matrix);
+		material.Apply();
+	});
+
+	if (!BENCHMARK_ALLOCATIONS)
+	{
+		// a check that can't run mustn't pass
+		std::cout << "FAIL: allocations not counted, build the Benchmark configuration (BENCHMARK_ALLOCATIONS 1)" << std::endl;
+		return 1;
+	}
+	if (handleAllocations != 0 || materialAllocations != 0)
+	{
+		std::cout << "FAIL: the uniform " << (handleAllocations != 0 ? "handle" : "material") << " path allocated" << std::endl;
+		return 1;
+	}
+	std::cout << "PASS: zero heap allocations in the uniform handle and material paths" << std::endl;
+	return 0;
+}
+
+// Program creation with an empty cache (every program compiles) vs a filled one (binaries only).
+// Drivers keep their own shader caches too, so cold is only truly cold on the first run.
+static int BenchStartup(GLFWwindow* window, const BenchmarkOptions& options)
+{
+	using clock = std::chrono::high_resolution_clock;
+	const unsigned int programs = 2;
+
+	// one compiler for both runs, only the library and its programs are measured
+	ShaderCompiler compiler;
+	auto measure = [&](const char* name)
+	{
+		ProgramCache::ResetStats();
+		auto start = clock::now();
+		ShaderLibrary shaders(compiler);
+		shaders.Get("resources/shaders/Basic.shader");
+		shaders.Get("resources/shaders/Basic.shader", ShaderDefines().Set("INSTANCED"));
+		ProgramCache::WarmUp();
+		double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+		const ProgramCacheStats& stats = ProgramCache::GetStats();
+		std::cout << name << "\t" << ms << " ms\t" << stats.Hits << " loaded (" << stats.LoadMs << " ms)\t"
+			<< stats.Misses << " compiled (" << stats.CompileMs << " ms)\t" << stats.Rejected << " rejected\t"
+			<< "warm-up " << stats.WarmUpMs << " ms" << std::endl;
+		return stats.Hits;
+	};
+
+	if (ProgramCache::GetDirectory().empty())
+	{
+		std::cout << "The program cache is disabled" << std::endl;
+		return 1;
+	}
+
+	ProgramCache::Clear();
+	measure("cold");
+	unsigned int hits = measure("warm");
+	if (hits != programs)
+	{
+		std::cout << "WARNING: the driver doesn't support program binaries, warm startup compiled from source" << std::endl;
+	}
+	return 0;
+}
+
+// Synthetic permutations of Basic.shader compiled in one batch by each ShaderCompiler mode,
+// with the program cache off. Every run gets its own define so the driver can't reuse
+// programs from the previous run.
+static int BenchCompile(GLFWwindow* window, const BenchmarkOptions& options)
+{
+	using clock = std::chrono::high_resolution_clock;
+	std::string cacheDirectory = ProgramCache::GetDirectory();
+	ProgramCache::SetDirectory("");
+
+	std::cout << "mode\tprograms\ttotal ms\tsubmit ms\tloading frames\tfailed\n";
+	const ShaderCompiler::Mode modes[] = { ShaderCompiler::MODE_SERIAL, ShaderCompiler::MODE_PARALLEL_EXTENSION, ShaderCompiler::MODE_WORKER_THREADS };
+	int result = 0;
+	for (unsigned int run = 0; run < 3; run++)
+	{
+		ShaderCompiler compiler(modes[run]);
+		const char* name = ShaderCompiler::GetModeName(modes[run]);
+		if (compiler.GetMode() != modes[run])
+		{
+			std::cout << name << "\tunavailable" << std::endl;
+			continue;
+		}
+
+		auto start = clock::now();
+		std::vector<std::shared_future<CompiledProgram>> programs;
+		for (unsigned int i = 0; i < options.Permutations; i++)
+		{
+			ShaderDefines defines;
+			defines.Set("PERMUTATION", std::to_string(i)).Set("BENCH_RUN", std::to_string(run));
+			if (i & 1) { defines.Set("INSTANCED"); }
+			ShaderProgramSource source = ShaderPreprocessor::Process("resources/shaders/Basic.shader", defines);
+			programs.push_back(compiler.Submit("Basic.shader", source, defines));
+		}
+		double submitMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+		// what the loading screen would do
+		unsigned int frames = 0;
+		while (!compiler.Poll())
+		{
+			GLCall(glClear(GL_COLOR_BUFFER_BIT));
+			glfwSwapBuffers(window);
+			glfwPollEvents();
+			frames++;
+		}
+		double totalMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+		unsigned int failed = 0;
+		for (const std::shared_future<CompiledProgram>& program : programs)
+		{
+			unsigned int id = program.get().Program;
+			failed += id == 0 ? 1 : 0;
+			ProgramCache::OnDeleteProgram(id);
+			GLCall(glDeleteProgram(id));
+		}
+		std::cout << name << "\t" << options.Permutations << "\t" << totalMs << "\t" << submitMs << "\t" << frames << "\t" << failed << std::endl;
+		result = failed > 0 ? 1 : result;
+	}
+
+	ProgramCache::SetDirectory(cacheDirectory);
+	return result;
+}
+
+// Loads the same image many times, once blocking inside a single frame and once through
+// the streamer, and reports the worst frame of each. Texture creation is what's measured,
+// the frames themselves only clear.
+static int BenchStreaming(GLFWwindow* window, const BenchmarkOptions& options)
+{
+	using clock = std::chrono::high_resolution_clock;
+	auto frame = [&]()
+	{
+		GLCall(glClear(GL_COLOR_BUFFER_BIT));
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+	};
+
+	std::cout << "loader\ttextures\ttotal ms\tframes\tworst frame ms\n";
+	{
+		std::vector<std::unique_ptr<Texture>> textures;
+		auto start = clock::now();
+		for (unsigned int i = 0; i < options.Textures; i++)
+		{
+			textures.push_back(std::make_unique<Texture>(options.Image));
+		}
+		frame();
+		double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+		std::cout << "blocking\t" << options.Textures << "\t" << ms << "\t1\t" << ms << std::endl;
+	}
+
+	TextureStreamer streamer;
+	std::vector<std::unique_ptr<Texture>> textures;
+	auto start = clock::now();
+	for (unsigned int i = 0; i < options.Textures; i++)
+	{
+		textures.push_back(Texture::LoadAsync(options.Image, streamer));
+	}
+	unsigned int frames = 0;
+	double worstMs = 0.0;
+	while (streamer.GetPendingCount() > 0)
+	{
+		auto frameStart = clock::now();
+		streamer.Update();
+		frame();
+		worstMs = std::max(worstMs, std::chrono::duration<double, std::milli>(clock::now() - frameStart).count());
+		frames++;
+	}
+	double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+	std::cout << "streamer\t" << options.Textures << "\t" << ms << "\t" << frames << "\t" << worstMs << std::endl;
+
+	const TextureStreamerStats& stats = streamer.GetStats();
+	return stats.Failed > 0 ? 1 : 0;
+}
+
+// Cooks the image into every block format in the temp directory and compares loading
+// the results with decoding the original through stb_image. Load times include glFinish,
+// so the upload is really done.
+static int BenchCooked(GLFWwindow* window, const BenchmarkOptions& options)
+{
+	using clock = std::chrono::high_resolution_clock;
+	auto load = [&](const std::string& path, unsigned int& memory)
+	{
+		auto start = clock::now();
+		for (unsigned int i = 0; i < options.Textures; i++)
+		{
+			Texture texture(path);
+			memory = texture.GetMemorySize();
+		}
+		GLCall(glFinish());
+		return std::chrono::duration<double, std::milli>(clock::now() - start).count() / options.Textures;
+	};
+
+	std::cout << "source\tlevels\tfile KB\tmemory KB\tload ms\tcook ms\n";
+	unsigned int memory = 0;
+	double ms = load(options.Image, memory);
+	std::cout << "stb\t1\t" << std::filesystem::file_size(options.Image) / 1024 << "\t" << memory / 1024 << "\t" << ms << "\t-" << std::endl;
+
+	const char* formats[] = { "bc1", "bc3", "bc7" };
+	for (const char* format : formats)
+	{
+		CookOptions cook;
+		cook.Input = options.Image;
+		cook.Format = format;
+		cook.Output = (std::filesystem::temp_directory_path() / (std::string("bench_") + format + ".ktx2")).string();
+		CookResult result;
+		if (!CookTexture(cook, result)) { return 1; }
+
+		ms = load(cook.Output, memory);
+		std::cout << format << "\t" << result.Levels << "\t" << std::filesystem::file_size(cook.Output) / 1024 << "\t"
+			<< memory / 1024 << "\t" << ms << "\t" << result.Ms << std::endl;
+		std::filesystem::remove(cook.Output);
+	}
+	return 0;
+}
+
+// A grid of cubes showing --textures distinct small images. With a texture per image the
+// render queue draws cube by cube and rebinds whenever the image changes. Packed into an
+// atlas or a TextureTable (array, and bindless where the driver has it) the whole grid is
+// one instanced draw reading per-instance regions or indices from an SSBO.
+static int BenchBatching(GLFWwindow* window, const BenchmarkOptions& options)
+{
+	const int IMAGE_SIZE = 32;
+	Renderer renderer;
+	ShaderCompiler compiler;
+	ShaderLibrary shaders(compiler);
+	unsigned int side = (unsigned int)std::ceil(std::sqrt((double)options.Cubes));
+	glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -1.5f * side));
+	glm::mat4 projection = glm::perspective(45.0f, 800.0f / 600.0f, 0.1f, 10000.0f);
+	GLStateCache::Get().SetEnabled(GL_DEPTH_TEST, true);
+	renderer.BeginScene(view, projection, 0.0f);
+
+	VertexBuffer vertexBuffer(CUBE_VERTICES, sizeof(CUBE_VERTICES));
+	VertexBufferLayout layout;
+	layout.Push<float>(3);
+	layout.Push<float>(2);
+	VertexArray vertexArray;
+	vertexArray.AddBuffer(vertexBuffer, layout);
+
+	std::vector<glm::mat4> models(options.Cubes);
+	for (unsigned int i = 0; i < options.Cubes; i++)
+	{
+		glm::vec3 position((float)(i % side) - side * 0.5f, (float)(i / side) - side * 0.5f, 0.0f);
+		models[i] = glm::translate(glm::mat4(1.0f), position * 1.5f);
+	}
+
+	// a checkerboard in its own colour per image
+	std::vector<std::unique_ptr<Texture>> textures;
+	TextureAtlas atlas;
+	TextureTable array(IMAGE_SIZE, IMAGE_SIZE, options.Textures, TextureTable::MODE_ARRAY);
+	TextureTable bindless(IMAGE_SIZE, IMAGE_SIZE, options.Textures, TextureTable::MODE_BINDLESS);
+	std::vector<unsigned char> pixels(IMAGE_SIZE * IMAGE_SIZE * 4);
+	for (unsigned int image = 0; image < options.Textures; image++)
+	{
+		for (int texel = 0; texel < IMAGE_SIZE * IMAGE_SIZE; texel++)
+		{
+			bool dark = ((texel % IMAGE_SIZE) / 4 + (texel / IMAGE_SIZE) / 4) & 1;
+			pixels[texel * 4 + 0] = (unsigned char)(image * 67 % 256 >> (dark ? 1 : 0));
+			pixels[texel * 4 + 1] = (unsigned char)(image * 131 % 256 >> (dark ? 1 : 0));
+			pixels[texel * 4 + 2] = (unsigned char)(image * 197 % 256 >> (dark ? 1 : 0));
+			pixels[texel * 4 + 3] = 255;
+		}
+		textures.push_back(std::make_unique<Texture>(IMAGE_SIZE, IMAGE_SIZE, pixels.data()));
+		atlas.Add(IMAGE_SIZE, IMAGE_SIZE, pixels.data());
+		array.Add(pixels.data());
+		bindless.Add(pixels.data());
+	}
+	atlas.Build();
+	if (atlas.GetPageCount() != 1)
+	{
+		std::cout << "The images need " << atlas.GetPageCount() << " atlas pages, the instanced draw reads one" << std::endl;
+		return 1;
+	}
+
+	std::vector<glm::vec4> regions(options.Cubes);
+	for (unsigned int i = 0; i < options.Cubes; i++) { regions[i] = atlas.GetRegion(i % options.Textures).UV; }
+	UniformBuffer regionBuffer((unsigned int)(regions.size() * sizeof(glm::vec4)), ATLAS_REGIONS_BINDING, GL_SHADER_STORAGE_BUFFER);
+	regionBuffer.SetData(regions.data(), (unsigned int)(regions.size() * sizeof(glm::vec4)));
+	std::vector<unsigned int> indices(options.Cubes);
+	for (unsigned int i = 0; i < options.Cubes; i++) { indices[i] = i % options.Textures; }
+	UniformBuffer indexBuffer((unsigned int)(indices.size() * sizeof(unsigned int)), INSTANCE_TEXTURES_BINDING, GL_SHADER_STORAGE_BUFFER);
+	indexBuffer.SetData(indices.data(), (unsigned int)(indices.size() * sizeof(unsigned int)));
+
+	Shader& shader = shaders.Get("resources/shaders/Basic.shader");
+	Shader& atlasShader = shaders.Get("resources/shaders/Basic.shader", ShaderDefines().Set("ATLAS").Set("INSTANCED"));
+	RenderQueue queue;
+
+	std::cout << "path\tcubes\timages\tcpu ms\tframe ms\tstate calls/frame\tdraw calls/frame\n";
+	GLStateCache::Get().ResetStats();
+	FrameTiming separate = TimeFrames(window, &renderer, options.Frames, [&]()
+	{
+		for (unsigned int i = 0; i < options.Cubes; i++)
+		{
+			DrawPacket packet = {};
+			packet.shader = &shader;
+			packet.vertexArray = &vertexArray;
+			packet.vertexCount = CUBE_VERTEX_COUNT;
+			packet.textures[0] = textures[i % options.Textures].get();
+			packet.model = models[i];
+			queue.Submit(packet);
+		}
+		queue.Flush();
+	});
+	std::cout << "textures\t" << options.Cubes << "\t" << options.Textures << "\t" << separate.CpuMs << "\t" << separate.FrameMs
+		<< "\t" << GLStateCache::Get().GetStats().Issued / options.Frames << "\t" << queue.GetStats().DrawCalls << std::endl;
+
+	GLStateCache::Get().ResetStats();
+	FrameTiming atlased = TimeFrames(window, &renderer, options.Frames, [&]()
+	{
+		atlas.GetPage(0).Bind(0);
+		renderer.DrawInstanced(vertexArray, atlasShader, models.data(), options.Cubes, CUBE_VERTEX_COUNT);
+	});
+	std::cout << "atlas\t" << options.Cubes << "\t" << options.Textures << "\t" << atlased.CpuMs << "\t" << atlased.FrameMs
+		<< "\t" << GLStateCache::Get().GetStats().Issued / options.Frames << "\t1" << std::endl;
+
+	for (const TextureTable* table : { &array, &bindless })
+	{
+		const char* name = TextureTable::GetModeName(table->GetMode());
+		if (table == &bindless && table->GetMode() != TextureTable::MODE_BINDLESS)
+		{
+			std::cout << "bindless\tunavailable" << std::endl;
+			continue;
+		}
+		Shader& tableShader = shaders.Get("resources/shaders/Basic.shader", table->GetDefines().Set("INSTANCED"));
+		Material material(tableShader);
+		// the instanced variant reads its indices from the SSBO
+		material.SetTextureTable(*table);
+
+		GLStateCache::Get().ResetStats();
+		FrameTiming timing = TimeFrames(window, &renderer, options.Frames, [&]()
+		{
+			material.Apply();
+			renderer.DrawInstanced(vertexArray, tableShader, models.data(), options.Cubes, CUBE_VERTEX_COUNT);
+		});
+		std::cout << name << "\t" << options.Cubes << "\t" << options.Textures << "\t" << timing.CpuMs << "\t" << timing.FrameMs
+			<< "\t" << GLStateCache::Get().GetStats().Issued / options.Frames << "\t1" << std::endl;
+	}
+
+	// the per-texture queue again, now collapsed into multi draws reading the image index
+	// from the DrawData SSBO, one texture array bound for all of them
+	Shader& multiDrawShader = shaders.Get("resources/shaders/Basic.shader", array.GetDefines().Set("MULTI_DRAW"));
+	// what the queue draws packet by packet when the stream buffer is full
+	Shader& packetShader = shaders.Get("resources/shaders/Basic.shader", array.GetDefines());
+	queue.SetMultiDraw(&renderer.GetStreamBuffer());
+	GLStateCache::Get().ResetStats();
+	FrameTiming multiDrawn = TimeFrames(window, &renderer, options.Frames, [&]()
+	{
+		array.Bind(0);
+		for (unsigned int i = 0; i < options.Cubes; i++)
+		{
+			DrawPacket packet = {};
+			packet.shader = &packetShader;
+			packet.multiDrawShader = &multiDrawShader;
+			packet.vertexArray = &vertexArray;
+			packet.vertexCount = CUBE_VERTEX_COUNT;
+			packet.model = models[i];
+			packet.material = i % options.Textures;
+			queue.Submit(packet);
+		}
+		queue.Flush();
+	});
+	const RenderQueueStats& stats = queue.GetStats();
+	std::cout << "multidraw\t" << options.Cubes << "\t" << options.Textures << "\t" << multiDrawn.CpuMs << "\t" << multiDrawn.FrameMs
+		<< "\t" << GLStateCache::Get().GetStats().Issued / options.Frames << "\t" << stats.DrawCalls << std::endl;
+	std::cout << "multi draw collapsed " << stats.DrawsCollapsed << " of " << stats.Packets << " draws a frame" << std::endl;
+	std::cout << "stream buffer overflows\t" << renderer.GetStreamBuffer().GetStats().Overflows << std::endl;
+	return 0;
+}
+
+// Asks for the same image --textures times, directly and through a ResourceManager, then
+// evicts everything and asks again so the decoded cache is what serves it.
+static int BenchResources(GLFWwindow* window, const BenchmarkOptions& options)
+{
+	using clock = std::chrono::high_resolution_clock;
+	auto elapsed = [](clock::time_point start)
+	{
+		GLCall(glFinish());
+		return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+	};
+
+	std::cout << "path\trequests\tms\thits\tmisses\tdecode hits\ttexture KB\tdecoded KB\n";
+	{
+		auto start = clock::now();
+		std::vector<std::unique_ptr<Texture>> textures;
+		for (unsigned int i = 0; i < options.Textures; i++) { textures.push_back(std::make_unique<Texture>(options.Image)); }
+		std::cout << "direct\t" << options.Textures << "\t" << elapsed(start) << std::endl;
+	}
+
+	ShaderCompiler compiler;
+	ShaderLibrary shaders(compiler);
+	ResourceManager resources(shaders);
+	auto report = [&](const char* name, double ms)
+	{
+		const ResourceStats& stats = resources.GetStats();
+		std::cout << name << "\t" << options.Textures << "\t" << ms << "\t" << stats.Hits << "\t" << stats.Misses << "\t"
+			<< stats.DecodeHits << "\t" << stats.TextureBytes / 1024 << "\t" << stats.DecodedBytes / 1024 << std::endl;
+	};
+
+	auto start = clock::now();
+	{
+		std::vector<std::shared_ptr<Texture>> textures;
+		for (unsigned int i = 0; i < options.Textures; i++) { textures.push_back(resources.GetTexture(options.Image)); }
+	}
+	report("manager", elapsed(start));
+
+	resources.SetTextureBudget(0);
+	resources.SetTextureBudget(RESOURCE_TEXTURE_BUDGET);
+	start = clock::now();
+	resources.GetTexture(options.Image);
+	report("evicted", elapsed(start));
+	return resources.GetStats().Misses == 2 && resources.GetStats().DecodeHits == 1 ? 0 : 1;
+}
+
+// Creates --textures textures, vertex buffers and index buffers with each resource backend,
+// with GL debug output on and off. The CPU time is driver overhead on this thread, the finish
+// is work the driver deferred, binds are the calls that reached GL through the state cache.
+static int BenchCreation(GLFWwindow* window, const BenchmarkOptions& options)
+{
+	using clock = std::chrono::high_resolution_clock;
+	int size = options.TextureSize ? (int)options.TextureSize : 256;
+	std::vector<unsigned char> pixels((size_t)size * size * 4, 255);
+	std::vector<unsigned int> indices(CUBE_VERTEX_COUNT);
+	for (unsigned int i = 0; i < CUBE_VERTEX_COUNT; i++) { indices[i] = i; }
+
+	std::vector<ResourceBackend> backends = { ResourceBackend::BindToEdit };
+	if (GLAD_GL_VERSION_4_5) { backends.push_back(ResourceBackend::DirectStateAccess); }
+	else { std::cout << "OpenGL 4.5 isn't available, only the bind-to-edit backend runs\n"; }
+	ResourceBackend previous = GetResourceBackend();
+	bool debugOutput = GLAD_GL_VERSION_4_3 && glIsEnabled(GL_DEBUG_OUTPUT);
+
+	std::cout << "backend\tdebug output\tobjects\tcreate us/object\tfinish ms\tdestroy us/object\tbinds\n";
+	for (ResourceBackend backend : backends)
+	{
+		for (bool debug : { false, true })
+		{
+			if (debug && !GLAD_GL_VERSION_4_3) { continue; }
+			if (GLAD_GL_VERSION_4_3)
+			{
+				if (debug) { GLCall(glEnable(GL_DEBUG_OUTPUT)); }
+				else { GLCall(glDisable(GL_DEBUG_OUTPUT)); }
+			}
+			SetResourceBackend(backend);
+			GLStateCache::Get().ResetStats();
+
+			std::vector<std::unique_ptr<Texture>> textures;
+			std::vector<std::unique_ptr<VertexBuffer>> vertexBuffers;
+			std::vector<std::unique_ptr<IndexBuffer>> indexBuffers;
+			auto start = clock::now();
+			for (unsigned int i = 0; i < options.Textures; i++)
+			{
+				textures.push_back(std::make_unique<Texture>(size, size, pixels.data()));
+				vertexBuffers.push_back(std::make_unique<VertexBuffer>(CUBE_VERTICES, (unsigned int)sizeof(CUBE_VERTICES)));
+				indexBuffers.push_back(std::make_unique<IndexBuffer>(indices.data(), CUBE_VERTEX_COUNT));
+			}
+			double createUs = std::chrono::duration<double, std::micro>(clock::now() - start).count() / (options.Textures * 3);
+			unsigned int binds = GLStateCache::Get().GetStats().Issued;
+
+			start = clock::now();
+			GLCall(glFinish());
+			double finishMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+			start = clock::now();
+			textures.clear();
+			vertexBuffers.clear();
+			indexBuffers.clear();
+			GLCall(glFinish());
+			double destroyUs = std::chrono::duration<double, std::micro>(clock::now() - start).count() / (options.Textures * 3);
+
+			std::cout << GetResourceBackendName(backend) << "\t" << (debug ? "on" : "off") << "\t" << options.Textures * 3 << "\t"
+				<< createUs << "\t" << finishMs << "\t" << destroyUs << "\t" << binds << std::endl;
+		}
+	}
+
+	if (GLAD_GL_VERSION_4_3)
+	{
+		if (debugOutput) { GLCall(glEnable(GL_DEBUG_OUTPUT)); }
+		else { GLCall(glDisable(GL_DEBUG_OUTPUT)); }
+	}
+	SetResourceBackend(previous);
+	return 0;
+}
+
+// imgui_demo drawn with the original ImGui render path (a VAO and glBufferData per command list,
+// everything backed up with glGet) and the cached one (one VAO per context, one StreamBuffer
+// allocation, backup from GLStateCache). Render ms is the render call alone; state calls are
+// what the cached path sent to GL through the cache, the original path doesn't use it.
+static int BenchImGui(GLFWwindow* window, const BenchmarkOptions& options)
+{
+	using clock = std::chrono::high_resolution_clock;
+	ImGui::CreateContext();
+	ImGui::GetIO().IniFilename = nullptr;
+	ImGui_ImplGlfwGL3_Init(window, false);
+	GLStateCache& cache = GLStateCache::Get();
+
+	std::cout << "path\tframes\tvertices\tdraws\trender ms\tframe ms\tstate calls/frame\tskipped/frame\n";
+	for (bool legacy : { true, false })
+	{
+		double renderMs = 0.0;
+		unsigned int vertices = 0, draws = 0;
+		cache.ResetStats();
+		FrameTiming timing = TimeFrames(window, nullptr, options.Frames, [&]()
+		{
+			ImGui_ImplGlfwGL3_NewFrame();
+			ImGui::ShowDemoWindow();
+			ImGui::Render();
+			ImDrawData* drawData = ImGui::GetDrawData();
+			vertices = drawData->TotalVtxCount;
+			draws = 0;
+			for (int i = 0; i < drawData->CmdListsCount; i++) { draws += drawData->CmdLists[i]->CmdBuffer.Size; }
+
+			auto start = clock::now();
+			if (legacy)
+			{
+				ImGui_ImplGlfwGL3_RenderDrawDataLegacy(drawData);
+				cache.Invalidate();
+			}
+			else { ImGui_ImplGlfwGL3_RenderDrawData(drawData); }
+			renderMs += std::chrono::duration<double, std::milli>(clock::now() - start).count();
+		});
+
+		std::cout << (legacy ? "original" : "cached") << "\t" << options.Frames << "\t" << vertices << "\t" << draws << "\t"
+			<< renderMs / options.Frames << "\t" << timing.FrameMs << "\t";
+		if (legacy) { std::cout << "-\t-" << std::endl; }
+		else
+		{
+			const GLStateCacheStats& stats = cache.GetStats();
+			std::cout << (double)stats.Issued / options.Frames << "\t" << (double)stats.Skipped / options.Frames << std::endl;
+		}
+	}
+
+	ImGui_ImplGlfwGL3_Shutdown();
+	ImGui::DestroyContext();
+	return 0;
+}
+
+// The Main scene rendered into an FBO for a fixed number of frames, reported as JSON
+static int BenchScene(GLFWwindow* window, const BenchmarkOptions& options)
+{
+	using clock = std::chrono::high_resolution_clock;
+
+	Renderer renderer;
+	ShaderCompiler compiler;
+	ShaderLibrary shaders(compiler);
+	ResourceManager resources(shaders);
+	CubeScene scene(resources, options.Cubes, options.TextureSize);
+	Framebuffer framebuffer(options.Width, options.Height);
+	CubeScene::DrawMode mode = options.Mode == "loop" ? CubeScene::DRAW_LOOP :
+		options.Mode == "queue" ? CubeScene::DRAW_QUEUE :
+		options.Mode == "multidraw" ? CubeScene::DRAW_MULTI : CubeScene::DRAW_INSTANCED;
+
+	glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -3.0f));
+	glm::mat4 projection = glm::perspective(45.0f, (float)options.Width / options.Height, 0.1f, 1000.0f);
+
+	framebuffer.Bind();
+	GLStateCache::Get().SetEnabled(GL_DEPTH_TEST, true);
+	GLCall(glClearColor(0.2f, 0.3f, 0.3f, 1.0f));
+
+	std::vector<unsigned int> queries(options.Frames);
+	GLCall(glGenQueries((GLsizei)queries.size(), queries.data()));
+	std::vector<double> cpuMs;
+	unsigned int drawCalls = 0;
+	GLStateCache::Get().ResetStats();
+
+	auto start = clock::now();
+	for (unsigned int i = 0; i < options.Frames; i++)
+	{
+		auto frameStart = clock::now();
+		GLCall(glBeginQuery(GL_TIME_ELAPSED, queries[i]));
+		GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+		// fixed time step so every run renders the same frames
+		renderer.BeginScene(view, projection, i / 60.0f);
+		scene.Update(i / 60.0f);
+		drawCalls += scene.Draw(renderer, mode, view);
+		renderer.EndFrame();
+		GLCall(glEndQuery(GL_TIME_ELAPSED));
+		cpuMs.push_back(std::chrono::duration<double, std::milli>(clock::now() - frameStart).count());
+
+		GLCall(glFlush());
+		glfwPollEvents();
+	}
+	GLCall(glFinish());
+	double wallMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+	GLStateCacheStats stateStats = GLStateCache::Get().GetStats();
+
+	std::vector<double> gpuMs;
+	for (unsigned int query : queries)
+	{
+		GLuint64 elapsed = 0;
+		GLCall(glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed));
+		gpuMs.push_back(elapsed / 1000000.0);
+	}
+	GLCall(glDeleteQueries((GLsizei)queries.size(), queries.data()));
+	framebuffer.Unbind();
+
+	Distribution cpu = Summarize(cpuMs);
+	Distribution gpu = Summarize(gpuMs);
+
+	std::ostringstream json;
+	json << "{\n"
+		<< "  \"benchmark\": \"scene\",\n"
+		<< "  \"renderer\": \"" << glGetString(GL_RENDERER) << "\",\n"
+		<< "  \"mode\": \"" << options.Mode << "\",\n"
+		<< "  \"cubes\": " << options.Cubes << ",\n"
+		<< "  \"textureSize\": " << options.TextureSize << ",\n"
+		<< "  \"frames\": " << options.Frames << ",\n"
+		<< "  \"cpuFrameMs\": " << cpu.Mean << ",\n"
+		<< "  \"cpuFrameMsP50\": " << cpu.P50 << ",\n"
+		<< "  \"cpuFrameMsP95\": " << cpu.P95 << ",\n"
+		<< "  \"gpuFrameMs\": " << gpu.Mean << ",\n"
+		<< "  \"gpuFrameMsP50\": " << gpu.P50 << ",\n"
+		<< "  \"gpuFrameMsP95\": " << gpu.P95 << ",\n"
+		<< "  \"wallFrameMs\": " << wallMs / options.Frames << ",\n"
+		<< "  \"drawCallsPerFrame\": " << drawCalls / options.Frames << ",\n"
+		<< "  \"stateCallsIssuedPerFrame\": " << stateStats.Issued / options.Frames << ",\n"
+		<< "  \"stateCallsSkippedPerFrame\": " << stateStats.Skipped / options.Frames << ",\n"
+		<< "  \"streamBufferOverflows\": " << renderer.GetStreamBuffer().GetStats().Overflows << "\n"
+		<< "}\n";
+
+	if (options.Output.empty())
+	{
+		std::cout << json.str();
+	}
+	else
+	{
+		std::ofstream(options.Output) << json.str();
+	}
+
+	if (options.Baseline.empty()) { return 0; }
+
+	std::ifstream baselineFile(options.Baseline);
+	if (!baselineFile)
+	{
+		std::cout << "Could not open baseline " << options.Baseline << "\n";
+		return -1;
+	}
+	std::stringstream baseline;
+	baseline << baselineFile.rdbuf();
+
+	// lower is better for every compared metric
+	const char* metrics[] = { "cpuFrameMs", "gpuFrameMs", "wallFrameMs", "drawCallsPerFrame", "stateCallsIssuedPerFrame" };
+	int regressions = 0;
+	for (const char* metric : metrics)
+	{
+		double before, after;
+		if (!ReadJsonNumber(baseline.str(), metric, before) || !ReadJsonNumber(json.str(), metric, after)) { continue; }
+
+		double change = before > 0.0 ? (after - before) / before : 0.0;
+		bool regressed = change > options.Threshold;
+		std::cout << (regressed ? "REGRESSION " : "ok         ") << metric << ": " << before << " -> " << after
+			<< " (" << (change >= 0.0 ? "+" : "") << change * 100.0 << "%)\n";
+		regressions += regressed ? 1 : 0;
+	}
+	return regressions > 0 ? 1 : 0;
+}
+
+bool ParseBenchmarkOptions(int argc, char** argv, BenchmarkOptions& options)
+{
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		std::string arg = argv[i];
+		std::string value = argv[i + 1];
+
+		if (arg == "--bench") { options.Name = value; }
+		else if (arg == "--cubes") { options.Cubes = std::stoul(value); }
+		else if (arg == "--texture-size") { options.TextureSize = std::stoul(value); }
+		else if (arg == "--frames") { options.Frames = std::max(1ul, std::stoul(value)); }
+		else if (arg == "--size") { std::sscanf(value.c_str(), "%dx%d", &options.Width, &options.Height); }
+		else if (arg == "--mode") { options.Mode = value; }
+		else if (arg == "--json") { options.Output = value; }
+		else if (arg == "--baseline") { options.Baseline = value; }
+		else if (arg == "--threshold") { options.Threshold = std::stof(value) / 100.0f; }
+		else if (arg == "--permutations") { options.Permutations = std::max(1ul, std::stoul(value)); }
+		else if (arg == "--image") { options.Image = value; }
+		else if (arg == "--textures") { options.Textures = std::max(1ul, std::stoul(value)); }
+		else { continue; }
+		i++;
+	}
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::string(argv[i]) == "--egl") { options.Egl = true; }
+	}
+	return !options.Name.empty();
+}
+
+int RunBenchmark(GLFWwindow* window, const BenchmarkOptions& options)
+{
+	// never wait for vsync while measuring
+	glfwSwapInterval(0);
+
+	if (options.Name == "scene") { return BenchScene(window, options); }
+	if (options.Name == "instancing") { return BenchInstancing(window, options); }
+	if (options.Name == "glcall") { return BenchGLCall(window, options); }
+	if (options.Name == "uniforms") { return BenchUniforms(window, options); }
+	if (options.Name == "startup") { return BenchStartup(window, options); }
+	if (options.Name == "compile") { return BenchCompile(window, options); }
+	if (options.Name == "streaming") { return BenchStreaming(window, options); }
+	if (options.Name == "cooked") { return BenchCooked(window, options); }
+	if (options.Name == "batching") { return BenchBatching(window, options); }
+	if (options.Name == "resources") { return BenchResources(window, options); }
+	if (options.Name == "creation") { return BenchCreation(window, options); }
+	if (options.Name == "imgui") { return BenchImGui(window, options); }
+
+	std::cout << "Unknown benchmark: " << options.Name << "\n";
+	return -1;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+
+struct GLFWwindow;
+
+// Command line: LearnOpenGL --bench <name> [options]
+//   names: scene, instancing, glcall, uniforms (fails unless built in the Benchmark configuration),
+//          startup (program cache cold vs warm),
+//          compile (serial vs parallel program compilation),
+//          streaming (worst frame while loading textures, blocking vs TextureStreamer),
+//          cooked (load time and memory of the stb path vs cooked BC1/BC3/BC7 KTX2 files),
+//          batching (a texture per cube vs TextureAtlas, texture array and bindless single draws
+//          vs multi draw indirect),
+//          resources (repeated loads of one image, direct vs ResourceManager),
+//          creation (texture and buffer creation with bind-to-edit vs DSA immutable storage),
+//          imgui (imgui_demo through the original ImGui render path vs the cached one)
+//   --cubes N            cubes in the scene (scene, batching)
+//   --texture-size N     generated texture size, 0 loads fortnite.jpg (scene), 0 is 256 (creation)
+//   --frames N           frames to render (scene, imgui)
+//   --size WxH           offscreen framebuffer size (scene)
+//   --mode M             loop, instanced, queue or multidraw (scene)
+//   --json FILE          write the report to FILE instead of stdout (scene)
+//   --baseline FILE      compare against an earlier report, exit code 1 on regressions (scene)
+//   --threshold PERCENT  allowed slowdown before a metric counts as regressed (scene)
+//   --permutations N     shader variants to compile (compile)
+//   --image FILE         image to load (streaming, cooked, resources)
+//   --textures N         copies of it to load at once (streaming, cooked, resources), distinct images (batching),
+//                        objects of each kind (creation)
+//   --egl                create the context through EGL on the hidden window (still needs X11 or Wayland,
+//                        e.g. Xvfb for Mesa/llvmpipe on a CI machine)
+struct BenchmarkOptions
+{
+	std::string Name;
+	unsigned int Cubes = 10000;
+	unsigned int TextureSize = 0;
+	unsigned int Frames = 300;
+	int Width = 1280, Height = 720;
+	std::string Mode = "instanced";
+	std::string Output;
+	std::string Baseline;
+	float Threshold = 0.1f;
+	unsigned int Permutations = 64;
+	std::string Image = "resources/textures/fortnite.jpg";
+	unsigned int Textures = 16;
+	bool Egl = false;
+};
+
+// Returns false when the command line doesn't ask for a benchmark
+bool ParseBenchmarkOptions(int argc, char** argv, BenchmarkOptions& options);
+// Runs the benchmark on the (hidden) window's context, results go to stdout unless --json is given
+int RunBenchmark(GLFWwindow* window, const BenchmarkOptions& options);
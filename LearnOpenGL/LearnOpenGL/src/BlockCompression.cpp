@@ -0,0 +1,337 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+unsigned int GetBlockSize(BlockFormat format)
+{
+	return format == BlockFormat::BC1 ? 8 : 16;
+}
+
+unsigned int GetCompressedSize(BlockFormat format, int width, int height)
+{
+	return ((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(format);
+}
+
+const char* GetBlockFormatName(BlockFormat format)
+{
+	switch (format)
+	{
+		case BlockFormat::BC1: return "bc1";
+		case BlockFormat::BC3: return "bc3";
+		case BlockFormat::BC7: return "bc7";
+	}
+	return "unknown";
+}
+
+// Principal axis of the block's colours (channels 0..count-1) by power iteration on the
+// covariance matrix, then the extremes of the pixels projected onto it. Good enough as
+// endpoints for a single-subset encoder and much cheaper than a search.
+static void FitEndpoints(const unsigned char* block, int channels, float* minimum, float* maximum)
+{
+	float mean[4] = {};
+	for (int i = 0; i < 16; i++)
+	{
+		for (int c = 0; c < channels; c++) { mean[c] += block[i * 4 + c]; }
+	}
+	for (int c = 0; c < channels; c++) { mean[c] /= 16.0f; }
+
+	float covariance[4][4] = {};
+	for (int i = 0; i < 16; i++)
+	{
+		float d[4];
+		for (int c = 0; c < channels; c++) { d[c] = block[i * 4 + c] - mean[c]; }
+		for (int a = 0; a < channels; a++)
+		{
+			for (int b = 0; b < channels; b++) { covariance[a][b] += d[a] * d[b]; }
+		}
+	}
+
+	float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	for (int iteration = 0; iteration < 4; iteration++)
+	{
+		float next[4] = {};
+		float length = 0.0f;
+		for (int a = 0; a < channels; a++)
+		{
+			for (int b = 0; b < channels; b++) { next[a] += covariance[a][b] * axis[b]; }
+			length = std::max(length, std::abs(next[a]));
+		}
+		// flat block, any axis works
+		if (length == 0.0f) { break; }
+		for (int c = 0; c < channels; c++) { axis[c] = next[c] / length; }
+	}
+
+	float low = 1e30f, high = -1e30f;
+	for (int i = 0; i < 16; i++)
+	{
+		float t = 0.0f;
+		for (int c = 0; c < channels; c++) { t += (block[i * 4 + c] - mean[c]) * axis[c]; }
+		low = std::min(low, t);
+		high = std::max(high, t);
+	}
+
+	float lengthSq = 0.0f;
+	for (int c = 0; c < channels; c++) { lengthSq += axis[c] * axis[c]; }
+	lengthSq = std::max(lengthSq, 1e-6f);
+	for (int c = 0; c < channels; c++)
+	{
+		// pulled in by 1/16 of the range, the extremes are rarely hit exactly
+		float inset = (high - low) / 16.0f;
+		minimum[c] = std::min(255.0f, std::max(0.0f, mean[c] + (low + inset) * axis[c] / lengthSq));
+		maximum[c] = std::min(255.0f, std::max(0.0f, mean[c] + (high - inset) * axis[c] / lengthSq));
+	}
+}
+
+static int ColorDistance(const unsigned char* a, const int* b, int channels)
+{
+	int distance = 0;
+	for (int c = 0; c < channels; c++)
+	{
+		int d = a[c] - b[c];
+		distance += d * d;
+	}
+	return distance;
+}
+
+static uint16_t PackRGB565(const float* color)
+{
+	int r = (int)(color[0] * 31.0f / 255.0f + 0.5f);
+	int g = (int)(color[1] * 63.0f / 255.0f + 0.5f);
+	int b = (int)(color[2] * 31.0f / 255.0f + 0.5f);
+	return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void UnpackRGB565(uint16_t packed, int* color)
+{
+	int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+	color[0] = (r << 3) | (r >> 2);
+	color[1] = (g << 2) | (g >> 4);
+	color[2] = (b << 3) | (b >> 2);
+}
+
+static void EncodeColorBlock(const unsigned char* block, unsigned char* output)
+{
+	float minimum[4], maximum[4];
+	FitEndpoints(block, 3, minimum, maximum);
+	uint16_t color0 = PackRGB565(maximum);
+	uint16_t color1 = PackRGB565(minimum);
+
+	// color0 > color1 selects the 4 colour mode, equal endpoints only need index 0
+	if (color0 < color1) { std::swap(color0, color1); }
+	int palette[4][3];
+	UnpackRGB565(color0, palette[0]);
+	UnpackRGB565(color1, palette[1]);
+	for (int c = 0; c < 3; c++)
+	{
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+
+	uint32_t indices = 0;
+	if (color0 != color1)
+	{
+		for (int i = 15; i >= 0; i--)
+		{
+			int best = 0, bestDistance = ColorDistance(&block[i * 4], palette[0], 3);
+			for (int p = 1; p < 4; p++)
+			{
+				int distance = ColorDistance(&block[i * 4], palette[p], 3);
+				if (distance < bestDistance) { best = p; bestDistance = distance; }
+			}
+			indices = (indices << 2) | best;
+		}
+	}
+
+	output[0] = color0 & 0xFF; output[1] = color0 >> 8;
+	output[2] = color1 & 0xFF; output[3] = color1 >> 8;
+	for (int i = 0; i < 4; i++) { output[4 + i] = (indices >> (8 * i)) & 0xFF; }
+}
+
+void EncodeBC1(const unsigned char* block, unsigned char* output)
+{
+	EncodeColorBlock(block, output);
+}
+
+void EncodeBC3(const unsigned char* block, unsigned char* output)
+{
+	int low = 255, high = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		low = std::min(low, (int)block[i * 4 + 3]);
+		high = std::max(high, (int)block[i * 4 + 3]);
+	}
+
+	// alpha0 > alpha1 selects 8 interpolated values
+	int palette[8];
+	palette[0] = high;
+	palette[1] = low;
+	for (int p = 1; p < 7; p++) { palette[p + 1] = ((7 - p) * high + p * low) / 7; }
+
+	uint64_t indices = 0;
+	if (high != low)
+	{
+		for (int i = 15; i >= 0; i--)
+		{
+			int best = 0, bestDistance = 256;
+			for (int p = 0; p < 8; p++)
+			{
+				int distance = std::abs(block[i * 4 + 3] - palette[p]);
+				if (distance < bestDistance) { best = p; bestDistance = distance; }
+			}
+			indices = (indices << 3) | best;
+		}
+	}
+
+	output[0] = (unsigned char)high;
+	output[1] = (unsigned char)low;
+	for (int i = 0; i < 6; i++) { output[2 + i] = (indices >> (8 * i)) & 0xFF; }
+	EncodeColorBlock(block, output + 8);
+}
+
+// BC7 writes its fields LSB first into one 128 bit block
+class BitWriter
+{
+private:
+	unsigned char* m_Output;
+	unsigned int m_Position;
+
+public:
+	BitWriter(unsigned char* output)
+		: m_Output(output), m_Position(0)
+	{
+		std::memset(output, 0, 16);
+	}
+
+	void Write(unsigned int value, unsigned int bits)
+	{
+		for (unsigned int i = 0; i < bits; i++, m_Position++)
+		{
+			if (value & (1u << i)) { m_Output[m_Position / 8] |= 1 << (m_Position % 8); }
+		}
+	}
+};
+
+static const int BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// 7 bits per channel plus a shared low bit, picks the p bit that lands closest
+static void QuantizeBC7Endpoint(const float* color, int* quantized, int& pbit)
+{
+	float bestError = 1e30f;
+	for (int p = 0; p < 2; p++)
+	{
+		int candidate[4];
+		float error = 0.0f;
+		for (int c = 0; c < 4; c++)
+		{
+			int value = std::min(127, std::max(0, (int)((color[c] - p) / 2.0f + 0.5f)));
+			candidate[c] = value;
+			float d = color[c] - ((value << 1) | p);
+			error += d * d;
+		}
+		if (error < bestError)
+		{
+			bestError = error;
+			pbit = p;
+			std::copy(candidate, candidate + 4, quantized);
+		}
+	}
+}
+
+void EncodeBC7(const unsigned char* block, unsigned char* output)
+{
+	float minimum[4], maximum[4];
+	FitEndpoints(block, 4, minimum, maximum);
+
+	int endpoints[2][4], pbits[2];
+	QuantizeBC7Endpoint(minimum, endpoints[0], pbits[0]);
+	QuantizeBC7Endpoint(maximum, endpoints[1], pbits[1]);
+
+	int palette[16][4];
+	for (int c = 0; c < 4; c++)
+	{
+		int e0 = (endpoints[0][c] << 1) | pbits[0];
+		int e1 = (endpoints[1][c] << 1) | pbits[1];
+		for (int p = 0; p < 16; p++)
+		{
+			palette[p][c] = ((64 - BC7_WEIGHTS4[p]) * e0 + BC7_WEIGHTS4[p] * e1 + 32) >> 6;
+		}
+	}
+
+	int indices[16];
+	for (int i = 0; i < 16; i++)
+	{
+		int best = 0, bestDistance = ColorDistance(&block[i * 4], palette[0], 4);
+		for (int p = 1; p < 16; p++)
+		{
+			int distance = ColorDistance(&block[i * 4], palette[p], 4);
+			if (distance < bestDistance) { best = p; bestDistance = distance; }
+		}
+		indices[i] = best;
+	}
+
+	// the first index is stored without its top bit, swapping the endpoints clears it
+	if (indices[0] & 8)
+	{
+		std::swap(endpoints[0], endpoints[1]);
+		std::swap(pbits[0], pbits[1]);
+		for (int& index : indices) { index = 15 - index; }
+	}
+
+	BitWriter writer(output);
+	writer.Write(1 << 6, 7);	// mode 6
+	for (int c = 0; c < 4; c++)
+	{
+		writer.Write(endpoints[0][c], 7);
+		writer.Write(endpoints[1][c], 7);
+	}
+	writer.Write(pbits[0], 1);
+	writer.Write(pbits[1], 1);
+	writer.Write(indices[0], 3);
+	for (int i = 1; i < 16; i++) { writer.Write(indices[i], 4); }
+}
+
+std::vector<unsigned char> CompressImage(const unsigned char* pixels, int width, int height,
+	BlockFormat format, unsigned int threads)
+{
+	int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	unsigned int blockSize = GetBlockSize(format);
+	std::vector<unsigned char> output(GetCompressedSize(format, width, height));
+
+	void (*encode)(const unsigned char*, unsigned char*) =
+		format == BlockFormat::BC1 ? EncodeBC1 : format == BlockFormat::BC3 ? EncodeBC3 : EncodeBC7;
+
+	std::atomic<int> nextRow(0);
+	auto worker = [&]()
+	{
+		unsigned char block[64];
+		for (int by = nextRow++; by < blocksY; by = nextRow++)
+		{
+			for (int bx = 0; bx < blocksX; bx++)
+			{
+				for (int y = 0; y < 4; y++)
+				{
+					int sy = std::min(by * 4 + y, height - 1);
+					for (int x = 0; x < 4; x++)
+					{
+						int sx = std::min(bx * 4 + x, width - 1);
+						std::memcpy(&block[(y * 4 + x) * 4], &pixels[((size_t)sy * width + sx) * 4], 4);
+					}
+				}
+				encode(block, &output[((size_t)by * blocksX + bx) * blockSize]);
+			}
+		}
+	};
+
+	if (threads == 0) { threads = std::max(1u, std::thread::hardware_concurrency()); }
+	threads = std::min(threads, (unsigned int)blocksY);
+	std::vector<std::thread> pool;
+	for (unsigned int i = 1; i < threads; i++) { pool.emplace_back(worker); }
+	worker();
+	for (std::thread& thread : pool) { thread.join(); }
+	return output;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+
+// 4x4 block compressed formats the texture cooker writes
+//   BC1  RGB, alpha is dropped, 8 bytes a block
+//   BC3  BC1 colour + interpolated alpha, 16 bytes a block
+//   BC7  mode 6 only (one subset, RGBA endpoints, 4 bit indices), 16 bytes a block
+enum class BlockFormat { BC1, BC3, BC7 };
+
+unsigned int GetBlockSize(BlockFormat format);
+// bytes of a whole width x height image, partial blocks round up
+unsigned int GetCompressedSize(BlockFormat format, int width, int height);
+const char* GetBlockFormatName(BlockFormat format);
+
+// block is 16 RGBA8 pixels, row by row
+void EncodeBC1(const unsigned char* block, unsigned char* output);
+void EncodeBC3(const unsigned char* block, unsigned char* output);
+void EncodeBC7(const unsigned char* block, unsigned char* output);
+
+// Compresses a tightly packed RGBA8 image, edge blocks repeat the last row/column.
+// Rows of blocks are shared out between threads, 0 uses every hardware thread.
+std::vector<unsigned char> CompressImage(const unsigned char* pixels, int width, int height,
+	BlockFormat format, unsigned int threads = 0);
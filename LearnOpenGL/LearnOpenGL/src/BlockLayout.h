@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+
+#include "glm/glm.hpp"
+
+// Compile-time std140 / std430 layout rules, used to check that a C++ struct
+// matches the GLSL block it is uploaded to:
+//
+//   using Layout = BlockDescription<BlockLayout::Std140, glm::mat4, float>;
+//   BLOCK_MEMBER_CHECK(MyBlock, Transform, Layout, 0);
+//   BLOCK_MEMBER_CHECK(MyBlock, Time, Layout, 1);
+enum class BlockLayout { Std140, Std430 };
+
+constexpr size_t AlignUp(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+template<typename T, BlockLayout L>
+struct BlockMember;
+
+template<BlockLayout L> struct BlockMember<float, L> { static constexpr size_t Size = 4, Align = 4; };
+template<BlockLayout L> struct BlockMember<int, L> { static constexpr size_t Size = 4, Align = 4; };
+template<BlockLayout L> struct BlockMember<unsigned int, L> { static constexpr size_t Size = 4, Align = 4; };
+template<BlockLayout L> struct BlockMember<glm::vec2, L> { static constexpr size_t Size = 8, Align = 8; };
+template<BlockLayout L> struct BlockMember<glm::vec3, L> { static constexpr size_t Size = 12, Align = 16; };
+template<BlockLayout L> struct BlockMember<glm::vec4, L> { static constexpr size_t Size = 16, Align = 16; };
+template<BlockLayout L> struct BlockMember<glm::mat4, L> { static constexpr size_t Size = 64, Align = 16; };
+
+// std140 rounds array strides up to a vec4, std430 keeps the element alignment
+template<typename T, size_t N, BlockLayout L>
+struct BlockMember<T[N], L>
+{
+	static constexpr size_t Align = L == BlockLayout::Std140 ? AlignUp(BlockMember<T, L>::Align, 16) : BlockMember<T, L>::Align;
+	static constexpr size_t Stride = AlignUp(BlockMember<T, L>::Size, Align);
+	static constexpr size_t Size = Stride * N;
+};
+
+template<BlockLayout L, typename... Members>
+struct BlockDescription
+{
+	static constexpr size_t Count = sizeof...(Members);
+
+	// Offset of member index, or the end of the last member when index == Count
+	static constexpr size_t Offset(size_t index)
+	{
+		const size_t sizes[] = { BlockMember<Members, L>::Size... };
+		const size_t aligns[] = { BlockMember<Members, L>::Align... };
+		size_t offset = 0;
+		for (size_t i = 0; i < index && i < Count; i++)
+		{
+			offset = AlignUp(offset, aligns[i]) + sizes[i];
+		}
+		return index < Count ? AlignUp(offset, aligns[index]) : offset;
+	}
+
+	// Total size, std140 rounds blocks up to a multiple of 16 bytes
+	static constexpr size_t Size()
+	{
+		const size_t aligns[] = { BlockMember<Members, L>::Align... };
+		size_t alignment = L == BlockLayout::Std140 ? 16 : 4;
+		for (size_t i = 0; i < Count; i++)
+		{
+			alignment = aligns[i] > alignment ? aligns[i] : alignment;
+		}
+		return AlignUp(Offset(Count), alignment);
+	}
+};
+
+#define BLOCK_MEMBER_CHECK(Struct, Member, Layout, Index) \
+	static_assert(offsetof(Struct, Member) == Layout::Offset(Index), #Struct "::" #Member " is not where the GLSL layout puts it")
+#define BLOCK_SIZE_CHECK(Struct, Layout) \
+	static_assert(sizeof(Struct) == Layout::Size(), #Struct " does not match the size of its GLSL block")
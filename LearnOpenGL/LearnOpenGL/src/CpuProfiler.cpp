@@ -0,0 +1,184 @@
+#include "CpuProfiler.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// events per thread, a full buffer drops new events until the flusher catches up
+static const uint32_t BUFFER_CAPACITY = 1 << 16;
+static const char FRAME_EVENT_NAME[] = "Frame";
+// frames are drawn on their own track in the trace
+static const uint32_t FRAME_TRACK_ID = 0;
+
+struct CpuProfileEvent
+{
+	const char* Name;
+	uint64_t Start;
+	uint64_t End;
+};
+
+// Single producer (the owning thread), single consumer (the flusher)
+struct CpuEventBuffer
+{
+	CpuProfileEvent Events[BUFFER_CAPACITY];
+	std::atomic<uint32_t> Head;
+	std::atomic<uint32_t> Tail;
+	std::atomic<uint32_t> Dropped;
+	uint32_t ThreadID;
+};
+
+std::atomic<bool> CpuProfiler::s_Active(false);
+
+static std::mutex s_BuffersMutex;
+static std::vector<std::unique_ptr<CpuEventBuffer>> s_Buffers;
+
+static std::ofstream s_Output;
+static bool s_FirstEvent = true;
+static std::thread s_Flusher;
+static std::mutex s_FlusherMutex;
+static std::condition_variable s_FlusherWake;
+static bool s_FlusherStop = false;
+static uint64_t s_SessionStart = 0;
+static uint64_t s_LastFrameMark = 0;
+
+static CpuEventBuffer& GetThreadBuffer()
+{
+	thread_local CpuEventBuffer* buffer = nullptr;
+	if (!buffer)
+	{
+		std::unique_ptr<CpuEventBuffer> created(new CpuEventBuffer());
+		created->Head = 0;
+		created->Tail = 0;
+		created->Dropped = 0;
+
+		std::lock_guard<std::mutex> lock(s_BuffersMutex);
+		created->ThreadID = (uint32_t)s_Buffers.size() + 1;
+		buffer = created.get();
+		s_Buffers.push_back(std::move(created));
+	}
+	return *buffer;
+}
+
+static void WriteEvent(const CpuProfileEvent& event, uint32_t threadID)
+{
+	// chrome traces are in microseconds relative to any origin
+	double start = (event.Start - s_SessionStart) / 1000.0;
+	double duration = (event.End - event.Start) / 1000.0;
+	bool frame = event.Name == FRAME_EVENT_NAME;
+
+	s_Output << (s_FirstEvent ? "\n" : ",\n");
+	s_FirstEvent = false;
+	s_Output << "{\"name\":\"";
+	for (const char* c = event.Name; *c; c++)
+	{
+		if (*c == '"' || *c == '\\') { s_Output << '\\'; }
+		s_Output << *c;
+	}
+	s_Output << "\",\"cat\":\"" << (frame ? "frame" : "cpu") << "\",\"ph\":\"X\",\"ts\":" << start
+		<< ",\"dur\":" << duration << ",\"pid\":0,\"tid\":" << (frame ? FRAME_TRACK_ID : threadID) << "}";
+}
+
+static void DrainBuffers()
+{
+	std::vector<CpuEventBuffer*> buffers;
+	{
+		std::lock_guard<std::mutex> lock(s_BuffersMutex);
+		for (auto& buffer : s_Buffers) { buffers.push_back(buffer.get()); }
+	}
+
+	for (CpuEventBuffer* buffer : buffers)
+	{
+		uint32_t tail = buffer->Tail.load(std::memory_order_relaxed);
+		uint32_t head = buffer->Head.load(std::memory_order_acquire);
+		for (uint32_t i = tail; i != head; i++)
+		{
+			WriteEvent(buffer->Events[i % BUFFER_CAPACITY], buffer->ThreadID);
+		}
+		buffer->Tail.store(head, std::memory_order_release);
+	}
+}
+
+static void FlusherMain()
+{
+	std::unique_lock<std::mutex> lock(s_FlusherMutex);
+	while (!s_FlusherStop)
+	{
+		s_FlusherWake.wait_for(lock, std::chrono::milliseconds(10));
+		DrainBuffers();
+	}
+	DrainBuffers();
+}
+
+uint64_t CpuProfiler::Now()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool CpuProfiler::BeginSession(const std::string& path)
+{
+	if (IsActive()) { return false; }
+
+	s_Output.open(path);
+	if (!s_Output) { return false; }
+
+	s_Output << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	s_FirstEvent = true;
+	s_SessionStart = Now();
+	s_LastFrameMark = s_SessionStart;
+	s_FlusherStop = false;
+	s_Flusher = std::thread(FlusherMain);
+	s_Active.store(true, std::memory_order_relaxed);
+	return true;
+}
+
+void CpuProfiler::EndSession()
+{
+	if (!IsActive()) { return; }
+	s_Active.store(false, std::memory_order_relaxed);
+
+	{
+		std::lock_guard<std::mutex> lock(s_FlusherMutex);
+		s_FlusherStop = true;
+	}
+	s_FlusherWake.notify_one();
+	s_Flusher.join();
+
+	std::lock_guard<std::mutex> lock(s_BuffersMutex);
+	for (auto& buffer : s_Buffers)
+	{
+		s_Output << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->ThreadID
+			<< ",\"args\":{\"name\":\"thread " << buffer->ThreadID << " (" << buffer->Dropped.load() << " dropped)\"}}";
+	}
+	s_Output << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << FRAME_TRACK_ID
+		<< ",\"args\":{\"name\":\"frames\"}}\n]}\n";
+	s_Output.close();
+}
+
+void CpuProfiler::FrameMark()
+{
+	if (!IsActive()) { return; }
+
+	uint64_t now = Now();
+	Record(FRAME_EVENT_NAME, s_LastFrameMark, now);
+	s_LastFrameMark = now;
+}
+
+void CpuProfiler::Record(const char* name, uint64_t start, uint64_t end)
+{
+	CpuEventBuffer& buffer = GetThreadBuffer();
+	uint32_t head = buffer.Head.load(std::memory_order_relaxed);
+	uint32_t tail = buffer.Tail.load(std::memory_order_acquire);
+	if (head - tail >= BUFFER_CAPACITY)
+	{
+		buffer.Dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	buffer.Events[head % BUFFER_CAPACITY] = { name, start, end };
+	buffer.Head.store(head + 1, std::memory_order_release);
+}
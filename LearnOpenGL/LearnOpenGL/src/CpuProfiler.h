@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Compile instrumentation out entirely with CPU_PROFILING 0
+#ifndef CPU_PROFILING
+	#define CPU_PROFILING 1
+#endif
+
+// Records CPU zones into per-thread lock-free ring buffers. A background thread drains
+// them into a Chrome trace-event JSON file (load it in chrome://tracing or Perfetto).
+// Names must be string literals, only the pointer is stored.
+class CpuProfiler
+{
+private:
+	static std::atomic<bool> s_Active;
+
+public:
+	static bool BeginSession(const std::string& path);
+	static void EndSession();
+
+	// Marks the end of a frame, frames show up as their own track in the trace
+	static void FrameMark();
+	static void Record(const char* name, uint64_t start, uint64_t end);
+	static uint64_t Now();
+
+	inline static bool IsActive() { return s_Active.load(std::memory_order_relaxed); }
+};
+
+class CpuProfileScope
+{
+private:
+	const char* m_Name;
+	uint64_t m_Start;
+
+public:
+	CpuProfileScope(const char* name)
+		: m_Name(name), m_Start(CpuProfiler::IsActive() ? CpuProfiler::Now() : 0) {}
+	~CpuProfileScope()
+	{
+		if (m_Start) { CpuProfiler::Record(m_Name, m_Start, CpuProfiler::Now()); }
+	}
+};
+
+#if CPU_PROFILING
+	#define PROFILE_SCOPE_CONCAT(a, b) a##b
+	#define PROFILE_SCOPE_NAME(line) PROFILE_SCOPE_CONCAT(cpuProfileScope, line)
+	#define PROFILE_SCOPE(name) CpuProfileScope PROFILE_SCOPE_NAME(__LINE__)(name)
+	#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+	#define PROFILE_FRAME_MARK() CpuProfiler::FrameMark()
+#else
+	#define PROFILE_SCOPE(name)
+	#define PROFILE_FUNCTION()
+	#define PROFILE_FRAME_MARK()
+#endif
@@ -0,0 +1,143 @@
+#include "CubeScene.h"
+#include "VertexBufferLayout.h"
+#include "Cube.h"
+#include "ShaderLibrary.h"
+#include "ResourceManager.h"
+
+#include <cmath>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+static constexpr UniformHandle MODEL_UNIFORM("u_Model");
+static constexpr UniformHandle TEXTURE_UNIFORM("u_Texture");
+
+static const glm::vec3 CUBE_POSITIONS[] = {
+	glm::vec3(0.0f,  0.0f,  0.0f),
+	glm::vec3(2.0f,  5.0f, -15.0f),
+	glm::vec3(-1.5f, -2.2f, -2.5f),
+	glm::vec3(-3.8f, -2.0f, -12.3f),
+	glm::vec3(2.4f, -0.4f, -3.5f),
+	glm::vec3(-1.7f,  3.0f, -7.5f),
+	glm::vec3(1.3f, -2.0f, -2.5f),
+	glm::vec3(1.5f,  2.0f, -2.5f),
+	glm::vec3(1.5f,  0.2f, -1.5f),
+	glm::vec3(-1.3f,  1.0f, -1.5f)
+};
+
+static const char* SHADER_PATH = "resources/shaders/Basic.shader";
+
+void CubeScene::PreloadShaders(ShaderLibrary& shaders)
+{
+	shaders.Preload(SHADER_PATH);
+	shaders.Preload(SHADER_PATH, ShaderDefines().Set("INSTANCED"));
+	shaders.Preload(SHADER_PATH, ShaderDefines().Set("MULTI_DRAW"));
+}
+
+CubeScene::CubeScene(ResourceManager& resources, unsigned int cubeCount, unsigned int textureSize)
+	: m_VertexBuffer(CUBE_VERTICES, sizeof(CUBE_VERTICES)),
+	m_Shader(resources.GetShader(SHADER_PATH)),
+	m_InstancedShader(resources.GetShader(SHADER_PATH, ShaderDefines().Set("INSTANCED"))),
+	m_MultiDrawShader(resources.GetShader(SHADER_PATH, ShaderDefines().Set("MULTI_DRAW"))),
+	m_Material(m_Shader),
+	m_InstancedMaterial(m_InstancedShader)
+{
+	VertexBufferLayout layout;
+	layout.Push<float>(3); // positions
+	layout.Push<float>(2); // texture coords
+	m_Shader.ValidateLayout(layout);
+	m_InstancedShader.ValidateLayout(layout);
+	m_MultiDrawShader.ValidateLayout(layout);
+	m_VertexArray.AddBuffer(m_VertexBuffer, layout);
+
+	if (textureSize == 0)
+	{
+		TextureParams params;
+		params.Async = true;
+		m_Texture = resources.GetTexture("resources/textures/fortnite.jpg", params);
+	}
+	else
+	{
+		std::vector<unsigned char> pixels(textureSize * textureSize * 4);
+		for (unsigned int y = 0; y < textureSize; y++)
+		{
+			for (unsigned int x = 0; x < textureSize; x++)
+			{
+				unsigned char value = ((x / 8 + y / 8) & 1) ? 255 : 64;
+				unsigned char* pixel = &pixels[(y * textureSize + x) * 4];
+				pixel[0] = value; pixel[1] = value; pixel[2] = value; pixel[3] = 255;
+			}
+		}
+		m_Texture = std::make_shared<Texture>(textureSize, textureSize, pixels.data());
+	}
+
+	m_Material.SetTexture(TEXTURE_UNIFORM, *m_Texture);
+	m_InstancedMaterial.SetTexture(TEXTURE_UNIFORM, *m_Texture);
+
+	unsigned int side = (unsigned int)std::ceil(std::sqrt((double)cubeCount));
+	for (unsigned int i = 0; i < cubeCount; i++)
+	{
+		if (i < 10)
+		{
+			m_Positions.push_back(CUBE_POSITIONS[i]);
+			continue;
+		}
+		unsigned int cell = i - 10;
+		glm::vec3 position((float)(cell % side) - side * 0.5f, (float)(cell / side) - side * 0.5f, -20.0f - side * 0.5f);
+		m_Positions.push_back(position * 1.5f);
+	}
+	m_Models.resize(cubeCount);
+}
+
+void CubeScene::Update(float time)
+{
+	float angle = time * 20.0f;
+	for (size_t i = 0; i < m_Positions.size(); i++)
+	{
+		glm::mat4 model(1.0f);
+		model = glm::translate(model, m_Positions[i]);
+		m_Models[i] = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
+	}
+}
+
+unsigned int CubeScene::Draw(Renderer& renderer, DrawMode mode, const glm::mat4& view)
+{
+	unsigned int count = GetCubeCount();
+
+	if (mode == DRAW_INSTANCED)
+	{
+		m_InstancedMaterial.Apply();
+		renderer.DrawInstanced(m_VertexArray, m_InstancedShader, m_Models.data(), count, CUBE_VERTEX_COUNT);
+		return 1;
+	}
+
+	if (mode == DRAW_QUEUE || mode == DRAW_MULTI)
+	{
+		m_Material.Apply();
+		m_Queue.SetMultiDraw(mode == DRAW_MULTI ? &renderer.GetStreamBuffer() : nullptr);
+		for (unsigned int i = 0; i < count; i++)
+		{
+			DrawPacket packet = {};
+			packet.shader = &m_Shader;
+			packet.vertexArray = &m_VertexArray;
+			packet.vertexCount = CUBE_VERTEX_COUNT;
+			packet.textures[0] = m_Texture.get();
+			packet.model = m_Models[i];
+			packet.depth = -(view * m_Models[i][3]).z;
+			packet.multiDrawShader = &m_MultiDrawShader;
+			m_Queue.Submit(packet);
+		}
+		m_Queue.Flush();
+		return m_Queue.GetStats().DrawCalls;
+	}
+
+	m_Material.Apply();
+	m_VertexArray.Bind();
+	for (unsigned int i = 0; i < count; i++)
+	{
+		m_Shader.Bind();
+		m_Shader.SetUniform(MODEL_UNIFORM, m_Models[i]);
+
+		GLCall(glDrawArrays(GL_TRIANGLES, 0, CUBE_VERTEX_COUNT));
+	}
+	return count;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Renderer.h"
+#include "RenderQueue.h"
+#include "Texture.h"
+#include "Material.h"
+
+class ShaderLibrary;
+class ResourceManager;
+
+// The spinning textured cubes from Main, shared with the benchmarks.
+// The first ten cubes keep their hand placed positions, the rest go on a grid behind them.
+class CubeScene
+{
+public:
+	enum DrawMode { DRAW_LOOP = 0, DRAW_INSTANCED = 1, DRAW_QUEUE = 2, DRAW_MULTI = 3 };
+
+private:
+	VertexArray m_VertexArray;
+	VertexBuffer m_VertexBuffer;
+	// Basic.shader, plain, with INSTANCED and with MULTI_DRAW, owned by the shader library
+	Shader& m_Shader;
+	Shader& m_InstancedShader;
+	Shader& m_MultiDrawShader;
+	std::shared_ptr<Texture> m_Texture;
+	Material m_Material;
+	Material m_InstancedMaterial;
+	RenderQueue m_Queue;
+	std::vector<glm::vec3> m_Positions;
+	std::vector<glm::mat4> m_Models;
+
+public:
+	// textureSize 0 loads fortnite.jpg, anything else generates a checkerboard of that size.
+	// The file streams in when the manager has a TextureStreamer, the cubes start out grey.
+	CubeScene(ResourceManager& resources, unsigned int cubeCount, unsigned int textureSize = 0);
+	// Starts compiling the scene's shader variants without waiting for them
+	static void PreloadShaders(ShaderLibrary& shaders);
+
+	void Update(float time);
+	// Returns the number of draw calls issued
+	unsigned int Draw(Renderer& renderer, DrawMode mode, const glm::mat4& view);
+
+	inline unsigned int GetCubeCount() const { return (unsigned int)m_Positions.size(); }
+	inline const RenderQueue& GetQueue() const { return m_Queue; }
+};
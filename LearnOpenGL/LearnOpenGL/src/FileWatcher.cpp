@@ -0,0 +1,129 @@
+#include "FileWatcher.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+constexpr std::chrono::milliseconds FileWatcher::POLL_INTERVAL;
+
+// one spelling per file so events and registrations compare equal
+static std::string Canonical(const std::string& path)
+{
+	std::error_code error;
+	fs::path canonical = fs::weakly_canonical(path, error);
+	return error ? path : canonical.string();
+}
+
+#ifdef __linux__
+
+FileWatcher::FileWatcher()
+	: m_Inotify(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+{
+	if (m_Inotify == -1) { std::cout << "[FileWatcher] inotify_init1 failed, changes won't be seen" << std::endl; }
+}
+
+FileWatcher::~FileWatcher()
+{
+	if (m_Inotify != -1) { close(m_Inotify); }
+}
+
+void FileWatcher::Add(const std::string& path)
+{
+	std::string file = Canonical(path);
+	if (std::find(m_Files.begin(), m_Files.end(), file) != m_Files.end()) { return; }
+	m_Files.push_back(file);
+	if (m_Inotify == -1) { return; }
+
+	// watching the same directory twice returns the same descriptor
+	std::string directory = fs::path(file).parent_path().string();
+	int watch = inotify_add_watch(m_Inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+	if (watch == -1)
+	{
+		std::cout << "[FileWatcher] Can't watch " << directory << std::endl;
+		return;
+	}
+	m_Directories[watch] = directory;
+}
+
+std::vector<std::string> FileWatcher::Poll()
+{
+	std::vector<std::string> changed;
+	if (m_Inotify == -1) { return changed; }
+
+	alignas(inotify_event) char buffer[4096];
+	ssize_t length;
+	while ((length = read(m_Inotify, buffer, sizeof(buffer))) > 0)
+	{
+		for (char* cursor = buffer; cursor < buffer + length; )
+		{
+			const inotify_event* event = (const inotify_event*)cursor;
+			cursor += sizeof(inotify_event) + event->len;
+
+			auto directory = m_Directories.find(event->wd);
+			if (directory == m_Directories.end() || event->len == 0) { continue; }
+
+			std::string file = (fs::path(directory->second) / event->name).string();
+			bool watched = std::find(m_Files.begin(), m_Files.end(), file) != m_Files.end();
+			if (watched && std::find(changed.begin(), changed.end(), file) == changed.end())
+			{
+				changed.push_back(file);
+			}
+		}
+	}
+	return changed;
+}
+
+#else
+
+static long long GetWriteTime(const std::string& path)
+{
+	std::error_code error;
+	auto time = fs::last_write_time(path, error);
+	return error ? 0 : (long long)time.time_since_epoch().count();
+}
+
+FileWatcher::FileWatcher()
+	: m_NextPoll(std::chrono::steady_clock::now())
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+}
+
+void FileWatcher::Add(const std::string& path)
+{
+	std::string file = Canonical(path);
+	if (std::find(m_Files.begin(), m_Files.end(), file) != m_Files.end()) { return; }
+	m_Files.push_back(file);
+	m_WriteTimes[file] = GetWriteTime(file);
+}
+
+std::vector<std::string> FileWatcher::Poll()
+{
+	std::vector<std::string> changed;
+	auto now = std::chrono::steady_clock::now();
+	if (now < m_NextPoll) { return changed; }
+	m_NextPoll = now + POLL_INTERVAL;
+
+	for (const std::string& file : m_Files)
+	{
+		long long time = GetWriteTime(file);
+		// 0 while the file is missing, e.g. halfway through an editor's save
+		if (time != 0 && time != m_WriteTimes[file])
+		{
+			m_WriteTimes[file] = time;
+			changed.push_back(file);
+		}
+	}
+	return changed;
+}
+
+#endif
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Reports files that were written since the last Poll. Uses inotify on Linux (watching the
+// parent directories, editors often save by replacing the file) and falls back to polling
+// modification times every POLL_INTERVAL elsewhere.
+class FileWatcher
+{
+private:
+	std::vector<std::string> m_Files;
+#ifdef __linux__
+	int m_Inotify;
+	std::unordered_map<int, std::string> m_Directories;	// watch descriptor -> directory
+#else
+	std::unordered_map<std::string, long long> m_WriteTimes;
+	std::chrono::steady_clock::time_point m_NextPoll;
+#endif
+
+public:
+	static constexpr std::chrono::milliseconds POLL_INTERVAL{ 250 };
+
+	FileWatcher();
+	~FileWatcher();
+
+	void Add(const std::string& path);
+	// Changed files, each reported once per Poll no matter how many writes happened
+	std::vector<std::string> Poll();
+};
@@ -0,0 +1,220 @@
+#include "FrameScheduler.h"
+#include "CpuProfiler.h"
+#include "StatsOverlay.h"
+
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "imgui/imgui.h"
+
+// the callbacks installed before the scheduler, still called first
+static GLFWcursorposfun s_CursorPosCallback = nullptr;
+static GLFWcursorenterfun s_CursorEnterCallback = nullptr;
+static GLFWmousebuttonfun s_MouseButtonCallback = nullptr;
+static GLFWscrollfun s_ScrollCallback = nullptr;
+static GLFWkeyfun s_KeyCallback = nullptr;
+static GLFWcharfun s_CharCallback = nullptr;
+static GLFWframebuffersizefun s_FramebufferSizeCallback = nullptr;
+static GLFWwindowrefreshfun s_WindowRefreshCallback = nullptr;
+static GLFWwindowfocusfun s_WindowFocusCallback = nullptr;
+
+static void MarkWindow(GLFWwindow* window, FrameSource source)
+{
+	if (FrameScheduler* scheduler = (FrameScheduler*)glfwGetWindowUserPointer(window)) { scheduler->MarkDirty(source); }
+}
+
+// user and kernel time of every thread, the driver's included. std::clock is wall time on MSVC.
+static double GetProcessCpuSeconds()
+{
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) { return 0.0; }
+	auto seconds = [](const FILETIME& time) { return (((uint64_t)time.dwHighDateTime << 32) | time.dwLowDateTime) * 1e-7; };
+	return seconds(kernel) + seconds(user);
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) { return 0.0; }
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
+
+FrameScheduler::FrameScheduler(GLFWwindow* window, bool eventDriven, double maxIdle)
+	: m_Window(window), m_EventDriven(eventDriven), m_MaxIdle(maxIdle),
+	m_DirtyFrames(FRAME_SCHEDULER_SETTLE_FRAMES), m_DirtySources(0), m_LastFrame(glfwGetTime()),
+	m_Current(), m_LastReport(), m_ReportStart(m_LastFrame), m_ReportCpuStart(GetProcessCpuSeconds())
+{
+	glfwSetWindowUserPointer(window, this);
+	s_CursorPosCallback = glfwSetCursorPosCallback(window, [](GLFWwindow* window, double x, double y)
+	{
+		if (s_CursorPosCallback) { s_CursorPosCallback(window, x, y); }
+		MarkWindow(window, FrameSource::Input);
+	});
+	s_CursorEnterCallback = glfwSetCursorEnterCallback(window, [](GLFWwindow* window, int entered)
+	{
+		if (s_CursorEnterCallback) { s_CursorEnterCallback(window, entered); }
+		MarkWindow(window, FrameSource::Input);
+	});
+	s_MouseButtonCallback = glfwSetMouseButtonCallback(window, [](GLFWwindow* window, int button, int action, int mods)
+	{
+		if (s_MouseButtonCallback) { s_MouseButtonCallback(window, button, action, mods); }
+		MarkWindow(window, FrameSource::Input);
+	});
+	s_ScrollCallback = glfwSetScrollCallback(window, [](GLFWwindow* window, double x, double y)
+	{
+		if (s_ScrollCallback) { s_ScrollCallback(window, x, y); }
+		MarkWindow(window, FrameSource::Input);
+	});
+	s_KeyCallback = glfwSetKeyCallback(window, [](GLFWwindow* window, int key, int scancode, int action, int mods)
+	{
+		if (s_KeyCallback) { s_KeyCallback(window, key, scancode, action, mods); }
+		MarkWindow(window, FrameSource::Input);
+	});
+	s_CharCallback = glfwSetCharCallback(window, [](GLFWwindow* window, unsigned int c)
+	{
+		if (s_CharCallback) { s_CharCallback(window, c); }
+		MarkWindow(window, FrameSource::Input);
+	});
+	s_FramebufferSizeCallback = glfwSetFramebufferSizeCallback(window, [](GLFWwindow* window, int width, int height)
+	{
+		if (s_FramebufferSizeCallback) { s_FramebufferSizeCallback(window, width, height); }
+		MarkWindow(window, FrameSource::Window);
+	});
+	s_WindowRefreshCallback = glfwSetWindowRefreshCallback(window, [](GLFWwindow* window)
+	{
+		if (s_WindowRefreshCallback) { s_WindowRefreshCallback(window); }
+		MarkWindow(window, FrameSource::Window);
+	});
+	s_WindowFocusCallback = glfwSetWindowFocusCallback(window, [](GLFWwindow* window, int focused)
+	{
+		if (s_WindowFocusCallback) { s_WindowFocusCallback(window, focused); }
+		MarkWindow(window, FrameSource::Window);
+	});
+}
+
+FrameScheduler::~FrameScheduler()
+{
+	glfwSetCursorPosCallback(m_Window, s_CursorPosCallback);
+	glfwSetCursorEnterCallback(m_Window, s_CursorEnterCallback);
+	glfwSetMouseButtonCallback(m_Window, s_MouseButtonCallback);
+	glfwSetScrollCallback(m_Window, s_ScrollCallback);
+	glfwSetKeyCallback(m_Window, s_KeyCallback);
+	glfwSetCharCallback(m_Window, s_CharCallback);
+	glfwSetFramebufferSizeCallback(m_Window, s_FramebufferSizeCallback);
+	glfwSetWindowRefreshCallback(m_Window, s_WindowRefreshCallback);
+	glfwSetWindowFocusCallback(m_Window, s_WindowFocusCallback);
+	glfwSetWindowUserPointer(m_Window, nullptr);
+}
+
+const char* FrameScheduler::GetSourceName(FrameSource source)
+{
+	switch (source)
+	{
+		case FrameSource::Input: return "input";
+		case FrameSource::Window: return "window";
+		case FrameSource::Animation: return "animation";
+		case FrameSource::AsyncLoad: return "async load";
+		case FrameSource::HotReload: return "hot reload";
+		case FrameSource::Timeout: return "timeout";
+	}
+	return "unknown";
+}
+
+void FrameScheduler::MarkDirty(FrameSource source)
+{
+	m_DirtyFrames = FRAME_SCHEDULER_SETTLE_FRAMES;
+	m_DirtySources |= 1u << (unsigned int)source;
+}
+
+bool FrameScheduler::WaitForFrame()
+{
+	PROFILE_FUNCTION();
+	double time = glfwGetTime();
+	if (!m_EventDriven || m_DirtyFrames > 0)
+	{
+		glfwPollEvents();
+	}
+	else
+	{
+		// callbacks mark what the events dirtied while we're in here
+		double timeout = m_LastFrame + m_MaxIdle - time;
+		if (timeout > 0.0)
+		{
+			glfwWaitEventsTimeout(timeout);
+			double woke = glfwGetTime();
+			m_Current.IdleSeconds += woke - time;
+			time = woke;
+		}
+		if (m_DirtyFrames == 0)
+		{
+			if (time - m_LastFrame < m_MaxIdle)
+			{
+				m_Current.Wakeups++;
+				UpdateReport(time);
+				return false;
+			}
+			MarkDirty(FrameSource::Timeout);
+		}
+	}
+
+	for (unsigned int i = 0; i < FRAME_SOURCE_COUNT; i++)
+	{
+		if (m_DirtySources & (1u << i)) { m_Current.SourceFrames[i]++; }
+	}
+	m_DirtySources = 0;
+	if (m_DirtyFrames > 0) { m_DirtyFrames--; }
+	m_Current.Frames++;
+	m_LastFrame = time;
+	UpdateReport(time);
+	return true;
+}
+
+void FrameScheduler::UpdateReport(double time)
+{
+	if (time - m_ReportStart < FRAME_SCHEDULER_REPORT_INTERVAL) { return; }
+
+	double cpu = GetProcessCpuSeconds();
+	m_Current.WallSeconds = time - m_ReportStart;
+	m_Current.CpuSeconds = cpu - m_ReportCpuStart;
+	m_LastReport = m_Current;
+	std::cout << "[FrameScheduler] " << m_LastReport.Frames << " frames in " << m_LastReport.WallSeconds << " s, idle "
+		<< 100.0 * m_LastReport.IdleSeconds / m_LastReport.WallSeconds << "%, CPU " << m_LastReport.CpuSeconds << " s ("
+		<< 100.0 * m_LastReport.CpuSeconds / m_LastReport.WallSeconds << "% of a core)\n";
+
+	m_Current = FrameSchedulerStats();
+	m_ReportStart = time;
+	m_ReportCpuStart = cpu;
+}
+
+void FrameScheduler::OnImGuiRender()
+{
+	BeginStatsSection();
+	bool eventDriven = m_EventDriven;
+	if (ImGui::Checkbox("Event driven", &eventDriven)) { m_EventDriven = eventDriven; }
+	ImGui::SameLine();
+	ImGui::Text("(max idle %.1f s)", m_MaxIdle);
+	const FrameSchedulerStats& stats = m_LastReport;
+	if (stats.WallSeconds > 0.0)
+	{
+		ImGui::Text("Last minute: %u frames, %.1f%% idle, CPU %.2f s (%.1f%% of a core)", stats.Frames,
+			100.0 * stats.IdleSeconds / stats.WallSeconds, stats.CpuSeconds, 100.0 * stats.CpuSeconds / stats.WallSeconds);
+		for (unsigned int i = 0; i < FRAME_SOURCE_COUNT; i++)
+		{
+			if (stats.SourceFrames[i]) { ImGui::Text("  %s: %u frames", GetSourceName((FrameSource)i), stats.SourceFrames[i]); }
+		}
+	}
+	else
+	{
+		ImGui::Text("First report after %.0f s", FRAME_SCHEDULER_REPORT_INTERVAL);
+	}
+	EndStatsOverlay();
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+struct GLFWwindow;
+
+// What asked for a frame
+enum class FrameSource { Input = 0, Window, Animation, AsyncLoad, HotReload, Timeout };
+const unsigned int FRAME_SOURCE_COUNT = 6;
+
+// default longest sleep without a frame, the overlay's numbers still move this often
+const double FRAME_SCHEDULER_MAX_IDLE = 1.0;
+// frames drawn after anything is marked dirty, ImGui shows the effect of input a frame late
+const unsigned int FRAME_SCHEDULER_SETTLE_FRAMES = 3;
+const double FRAME_SCHEDULER_REPORT_INTERVAL = 60.0;
+
+struct FrameSchedulerStats
+{
+	double WallSeconds;
+	double IdleSeconds;		// asleep in glfwWaitEventsTimeout
+	double CpuSeconds;		// process CPU time over every thread, the power proxy
+	unsigned int Frames;
+	unsigned int Wakeups;	// waits that ended without anything to draw
+	unsigned int SourceFrames[FRAME_SOURCE_COUNT];
+};
+
+// Decides whether the main loop draws a frame. Event driven, nothing is drawn until something
+// is marked dirty: GLFW input and window events mark themselves (the scheduler chains onto the
+// window's callbacks, install it after ImGui's), the app marks animation, finishing async loads
+// and shader reloads every frame they're in progress. While nothing is dirty WaitForFrame
+// sleeps in glfwWaitEventsTimeout, but never longer than the max idle interval. Otherwise it
+// polls and every iteration is a frame, like before.
+// Every FRAME_SCHEDULER_REPORT_INTERVAL seconds the idle ratio and CPU time go to stdout.
+class FrameScheduler
+{
+private:
+	GLFWwindow* m_Window;
+	bool m_EventDriven;
+	double m_MaxIdle;
+	unsigned int m_DirtyFrames;
+	unsigned int m_DirtySources;	// a bit per FrameSource marked since the last frame
+	double m_LastFrame;
+	FrameSchedulerStats m_Current;
+	FrameSchedulerStats m_LastReport;
+	double m_ReportStart;
+	double m_ReportCpuStart;
+
+	void UpdateReport(double time);
+
+public:
+	FrameScheduler(GLFWwindow* window, bool eventDriven, double maxIdle = FRAME_SCHEDULER_MAX_IDLE);
+	~FrameScheduler();
+
+	void MarkDirty(FrameSource source);
+	// Polls or waits for events, true when this iteration should draw a frame
+	bool WaitForFrame();
+
+	inline void SetEventDriven(bool eventDriven) { m_EventDriven = eventDriven; }
+	inline bool IsEventDriven() const { return m_EventDriven; }
+	inline void SetMaxIdle(double seconds) { m_MaxIdle = seconds; }
+	// the last complete report interval, all zero before the first one
+	inline const FrameSchedulerStats& GetStats() const { return m_LastReport; }
+	void OnImGuiRender();
+
+	static const char* GetSourceName(FrameSource source);
+};
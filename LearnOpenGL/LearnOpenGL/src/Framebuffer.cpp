@@ -0,0 +1,74 @@
+#include "Framebuffer.h"
+#include "Renderer.h"
+#include "GLStateCache.h"
+
+#include <iostream>
+
+Framebuffer::Framebuffer(int width, int height)
+	: m_RendererID(0), m_ColorAttachment(0), m_DepthAttachment(0),
+	m_Width(width), m_Height(height)
+{
+	Create();
+}
+
+Framebuffer::~Framebuffer()
+{
+	Destroy();
+}
+
+void Framebuffer::Create()
+{
+	GLCall(glGenFramebuffers(1, &m_RendererID));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_RendererID));
+
+	GLCall(glGenTextures(1, &m_ColorAttachment));
+	GLStateCache::Get().BindTexture(GL_TEXTURE_2D, m_ColorAttachment);
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_ColorAttachment, 0));
+	GLStateCache::Get().BindTexture(GL_TEXTURE_2D, 0);
+
+	GLCall(glGenRenderbuffers(1, &m_DepthAttachment));
+	GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_DepthAttachment));
+	GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_Width, m_Height));
+	GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_DepthAttachment));
+
+	GLCall(GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER));
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR::FRAMEBUFFER::INCOMPLETE (" << status << ")" << std::endl;
+	}
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
+
+void Framebuffer::Destroy()
+{
+	GLStateCache::Get().OnDeleteTexture(m_ColorAttachment);
+	GLCall(glDeleteTextures(1, &m_ColorAttachment));
+	GLCall(glDeleteRenderbuffers(1, &m_DepthAttachment));
+	GLCall(glDeleteFramebuffers(1, &m_RendererID));
+}
+
+void Framebuffer::Resize(int width, int height)
+{
+	if (width == m_Width && height == m_Height) { return; }
+
+	Destroy();
+	m_Width = width;
+	m_Height = height;
+	Create();
+}
+
+void Framebuffer::Bind() const
+{
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_RendererID));
+	GLStateCache::Get().SetViewport(0, 0, m_Width, m_Height);
+}
+
+void Framebuffer::Unbind() const
+{
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
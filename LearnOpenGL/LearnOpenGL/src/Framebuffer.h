@@ -0,0 +1,28 @@
+#pragma once
+
+// Offscreen render target with an RGBA8 color texture and a depth/stencil renderbuffer
+class Framebuffer
+{
+private:
+	unsigned int m_RendererID;
+	unsigned int m_ColorAttachment;
+	unsigned int m_DepthAttachment;
+	int m_Width, m_Height;
+
+	void Create();
+	void Destroy();
+
+public:
+	Framebuffer(int width, int height);
+	~Framebuffer();
+
+	void Resize(int width, int height);
+
+	// Binds the framebuffer and sets the viewport to cover it
+	void Bind() const;
+	void Unbind() const;
+
+	inline unsigned int GetColorAttachment() const { return m_ColorAttachment; }
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+};
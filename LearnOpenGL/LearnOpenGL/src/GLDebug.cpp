@@ -0,0 +1,118 @@
+#include "GLDebug.h"
+#include "Renderer.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+thread_local GLCallSite g_GLCallSite = { "unknown", "unknown", 0 };
+
+// every distinct message is printed this many times before it is only counted
+static const unsigned int MAX_REPEATS = 3;
+// no more than this many messages per second get printed overall
+static const unsigned int MAX_MESSAGES_PER_SECOND = 20;
+
+struct GLDebugMessageInfo
+{
+	std::string Text;
+	unsigned int Count;
+};
+
+static std::mutex s_Mutex;
+static std::unordered_map<unsigned long long, GLDebugMessageInfo> s_Messages;
+static std::thread::id s_ContextThread;
+static std::chrono::steady_clock::time_point s_WindowStart;
+static unsigned int s_WindowMessages = 0;
+static unsigned int s_RateLimited = 0;
+
+static const char* GetSeverityName(GLenum severity)
+{
+	switch (severity)
+	{
+		case GL_DEBUG_SEVERITY_HIGH: return "high";
+		case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+		case GL_DEBUG_SEVERITY_LOW: return "low";
+	}
+	return "notification";
+}
+
+static void APIENTRY GLDebugCallback(GLenum source, GLenum type, GLuint id, GLenum severity,
+	GLsizei length, const GLchar* message, const void* userParam)
+{
+	// the driver may call us from its own thread, the call site marker is only meaningful on ours
+	bool onContextThread = std::this_thread::get_id() == s_ContextThread;
+	GLCallSite site = onContextThread ? g_GLCallSite : GLCallSite{ "unknown (driver thread)", "unknown", 0 };
+
+	unsigned long long key = ((unsigned long long)source << 48) ^ ((unsigned long long)type << 32) ^ id;
+
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	GLDebugMessageInfo& info = s_Messages[key];
+	if (info.Count++ == 0)
+	{
+		info.Text = std::string(message, length > 0 ? length : strlen(message));
+	}
+	if (info.Count > MAX_REPEATS) { return; }
+
+	auto now = std::chrono::steady_clock::now();
+	if (now - s_WindowStart > std::chrono::seconds(1))
+	{
+		if (s_RateLimited > 0)
+		{
+			std::cout << "[OpenGL Debug] " << s_RateLimited << " messages dropped by the rate limit" << std::endl;
+		}
+		s_WindowStart = now;
+		s_WindowMessages = 0;
+		s_RateLimited = 0;
+	}
+	if (++s_WindowMessages > MAX_MESSAGES_PER_SECOND) { s_RateLimited++; return; }
+
+	std::cout << "[OpenGL Debug] (" << id << ", " << GetSeverityName(severity) << "): " << info.Text << "\n"
+		<< "    at " << site.Function << " " << site.File << ": " << site.Line << std::endl;
+	if (info.Count == MAX_REPEATS)
+	{
+		std::cout << "    (further repeats of this message are suppressed)" << std::endl;
+	}
+}
+
+bool GLDebugInit()
+{
+#if GL_ERROR_CHECK != GL_ERROR_CHECK_NONE
+	if (!GLAD_GL_VERSION_4_3)
+	{
+		std::cout << "Warning: GL debug output needs OpenGL 4.3, only GLCall checks are active." << std::endl;
+		return false;
+	}
+
+	s_ContextThread = std::this_thread::get_id();
+	s_WindowStart = std::chrono::steady_clock::now();
+
+	GLCall(glEnable(GL_DEBUG_OUTPUT));
+#if GL_ERROR_CHECK == GL_ERROR_CHECK_SYNC
+	GLCall(glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS));
+#endif
+	GLCall(glDebugMessageCallback(GLDebugCallback, nullptr));
+	// notifications are mostly buffer placement chatter
+	GLCall(glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE));
+	return true;
+#else
+	return false;
+#endif
+}
+
+void GLDebugShutdown()
+{
+	std::lock_guard<std::mutex> lock(s_Mutex);
+	for (const auto& message : s_Messages)
+	{
+		if (message.second.Count > MAX_REPEATS)
+		{
+			std::cout << "[OpenGL Debug] " << message.second.Count - MAX_REPEATS << " repeats suppressed: "
+				<< message.second.Text << std::endl;
+		}
+	}
+	s_Messages.clear();
+}
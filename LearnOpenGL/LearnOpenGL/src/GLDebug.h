@@ -0,0 +1,39 @@
+#pragma once
+
+// GL error checking modes, choose one by defining GL_ERROR_CHECK
+//   GL_ERROR_CHECK_SYNC:  glGetError around every GLCall plus synchronous debug output (slow, exact)
+//   GL_ERROR_CHECK_ASYNC: debug message callback only, GLCall just records its call site
+//   GL_ERROR_CHECK_NONE:  compiled out
+#define GL_ERROR_CHECK_NONE 0
+#define GL_ERROR_CHECK_ASYNC 1
+#define GL_ERROR_CHECK_SYNC 2
+
+#ifndef GL_ERROR_CHECK
+	#ifdef _DEBUG
+		#define GL_ERROR_CHECK GL_ERROR_CHECK_ASYNC
+	#else
+		#define GL_ERROR_CHECK GL_ERROR_CHECK_NONE
+	#endif
+#endif
+
+// The GL call most recently issued on this thread, used to attribute debug messages
+struct GLCallSite
+{
+	const char* Function;
+	const char* File;
+	int Line;
+};
+
+extern thread_local GLCallSite g_GLCallSite;
+
+inline void GLSetCallSite(const char* function, const char* file, int line)
+{
+	g_GLCallSite.Function = function;
+	g_GLCallSite.File = file;
+	g_GLCallSite.Line = line;
+}
+
+// Installs the debug message callback on the current context, needs GL 4.3 (KHR_debug)
+bool GLDebugInit();
+// Prints how many repeats of each message were suppressed
+void GLDebugShutdown();
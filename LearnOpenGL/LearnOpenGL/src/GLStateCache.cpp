@@ -0,0 +1,254 @@
+#include "GLStateCache.h"
+#include "Renderer.h"
+
+#include <GLFW/glfw3.h>
+
+#include <mutex>
+#include <unordered_map>
+
+// marks a shadowed value that doesn't match any real GL state
+static const unsigned int UNKNOWN = 0xFFFFFFFF;
+
+GLStateCache::GLStateCache()
+	: m_Stats({ 0, 0 })
+{
+	Invalidate();
+}
+
+GLStateCache& GLStateCache::Get()
+{
+	// one cache per context, looked up once per thread until the thread switches context
+	static std::unordered_map<GLFWwindow*, GLStateCache> caches;
+	thread_local GLFWwindow* currentContext = nullptr;
+	thread_local GLStateCache* currentCache = nullptr;
+
+	GLFWwindow* context = glfwGetCurrentContext();
+	if (!currentCache || context != currentContext)
+	{
+		static std::mutex mutex;
+		std::lock_guard<std::mutex> lock(mutex);
+		currentContext = context;
+		currentCache = &caches[context];
+	}
+	return *currentCache;
+}
+
+int GLStateCache::GetBufferTarget(unsigned int target)
+{
+	switch (target)
+	{
+		case GL_ARRAY_BUFFER: return ARRAY_BUFFER;
+		case GL_ELEMENT_ARRAY_BUFFER: return ELEMENT_ARRAY_BUFFER;
+		case GL_UNIFORM_BUFFER: return UNIFORM_BUFFER;
+		case GL_SHADER_STORAGE_BUFFER: return SHADER_STORAGE_BUFFER;
+		case GL_DRAW_INDIRECT_BUFFER: return DRAW_INDIRECT_BUFFER;
+		case GL_PIXEL_UNPACK_BUFFER: return PIXEL_UNPACK_BUFFER;
+	}
+	return -1;
+}
+
+int GLStateCache::GetTextureTarget(unsigned int target)
+{
+	switch (target)
+	{
+		case GL_TEXTURE_2D: return TEXTURE_2D;
+		case GL_TEXTURE_2D_ARRAY: return TEXTURE_2D_ARRAY;
+	}
+	return -1;
+}
+
+int GLStateCache::GetCapability(unsigned int capability)
+{
+	switch (capability)
+	{
+		case GL_BLEND: return BLEND;
+		case GL_DEPTH_TEST: return DEPTH_TEST;
+		case GL_CULL_FACE: return CULL_FACE;
+		case GL_SCISSOR_TEST: return SCISSOR_TEST;
+	}
+	return -1;
+}
+
+void GLStateCache::UseProgram(unsigned int program)
+{
+	if (m_Program == program) { m_Stats.Skipped++; return; }
+
+	GLCall(glUseProgram(program));
+	m_Program = program;
+	m_Stats.Issued++;
+}
+
+void GLStateCache::BindVertexArray(unsigned int vertexArray)
+{
+	if (m_VertexArray == vertexArray) { m_Stats.Skipped++; return; }
+
+	GLCall(glBindVertexArray(vertexArray));
+	m_VertexArray = vertexArray;
+	// the element buffer binding is part of the VAO
+	m_Buffers[ELEMENT_ARRAY_BUFFER] = UNKNOWN;
+	m_Stats.Issued++;
+}
+
+void GLStateCache::BindBuffer(unsigned int target, unsigned int buffer)
+{
+	int index = GetBufferTarget(target);
+	if (index >= 0 && m_Buffers[index] == buffer) { m_Stats.Skipped++; return; }
+
+	GLCall(glBindBuffer(target, buffer));
+	if (index >= 0) { m_Buffers[index] = buffer; }
+	m_Stats.Issued++;
+}
+
+void GLStateCache::ActiveTexture(unsigned int unit)
+{
+	if (m_ActiveTexture == unit) { m_Stats.Skipped++; return; }
+
+	GLCall(glActiveTexture(GL_TEXTURE0 + unit));
+	m_ActiveTexture = unit;
+	m_Stats.Issued++;
+}
+
+void GLStateCache::BindTexture(unsigned int target, unsigned int texture)
+{
+	int index = GetTextureTarget(target);
+	bool tracked = index >= 0 && m_ActiveTexture < GL_STATE_CACHE_TEXTURE_UNITS;
+	if (tracked && m_Textures[m_ActiveTexture][index] == texture) { m_Stats.Skipped++; return; }
+
+	GLCall(glBindTexture(target, texture));
+	if (tracked) { m_Textures[m_ActiveTexture][index] = texture; }
+	m_Stats.Issued++;
+}
+
+void GLStateCache::SetEnabled(unsigned int capability, bool enabled)
+{
+	int index = GetCapability(capability);
+	if (index >= 0 && m_Capabilities[index] == (int)enabled) { m_Stats.Skipped++; return; }
+
+	if (enabled) { GLCall(glEnable(capability)); }
+	else { GLCall(glDisable(capability)); }
+	if (index >= 0) { m_Capabilities[index] = (int)enabled; }
+	m_Stats.Issued++;
+}
+
+void GLStateCache::SetViewport(int x, int y, int width, int height)
+{
+	if (m_Viewport[0] == x && m_Viewport[1] == y && m_Viewport[2] == width && m_Viewport[3] == height)
+	{
+		m_Stats.Skipped++;
+		return;
+	}
+
+	GLCall(glViewport(x, y, width, height));
+	m_Viewport[0] = x; m_Viewport[1] = y; m_Viewport[2] = width; m_Viewport[3] = height;
+	m_Stats.Issued++;
+}
+
+void GLStateCache::SetBlendFunc(unsigned int source, unsigned int destination)
+{
+	SetBlendFuncSeparate(source, destination, source, destination);
+}
+
+void GLStateCache::SetBlendFuncSeparate(unsigned int sourceRGB, unsigned int destinationRGB, unsigned int sourceAlpha, unsigned int destinationAlpha)
+{
+	if (m_BlendFactors[0] == sourceRGB && m_BlendFactors[1] == destinationRGB &&
+		m_BlendFactors[2] == sourceAlpha && m_BlendFactors[3] == destinationAlpha)
+	{
+		m_Stats.Skipped++;
+		return;
+	}
+
+	GLCall(glBlendFuncSeparate(sourceRGB, destinationRGB, sourceAlpha, destinationAlpha));
+	m_BlendFactors[0] = sourceRGB; m_BlendFactors[1] = destinationRGB;
+	m_BlendFactors[2] = sourceAlpha; m_BlendFactors[3] = destinationAlpha;
+	m_Stats.Issued++;
+}
+
+void GLStateCache::SetBlendEquation(unsigned int mode)
+{
+	if (m_BlendEquation == mode) { m_Stats.Skipped++; return; }
+
+	GLCall(glBlendEquation(mode));
+	m_BlendEquation = mode;
+	m_Stats.Issued++;
+}
+
+int GLStateCache::IsEnabled(unsigned int capability) const
+{
+	int index = GetCapability(capability);
+	return index >= 0 ? m_Capabilities[index] : -1;
+}
+
+bool GLStateCache::GetViewport(int* viewport) const
+{
+	if (m_Viewport[2] < 0) { return false; }
+	for (int i = 0; i < 4; i++) { viewport[i] = m_Viewport[i]; }
+	return true;
+}
+
+bool GLStateCache::GetBlendFuncSeparate(unsigned int* factors) const
+{
+	if (m_BlendFactors[0] == UNKNOWN) { return false; }
+	for (int i = 0; i < 4; i++) { factors[i] = m_BlendFactors[i]; }
+	return true;
+}
+
+bool GLStateCache::GetBlendEquation(unsigned int& mode) const
+{
+	mode = m_BlendEquation;
+	return m_BlendEquation != UNKNOWN;
+}
+
+void GLStateCache::Invalidate()
+{
+	m_Program = UNKNOWN;
+	m_VertexArray = UNKNOWN;
+	for (unsigned int& buffer : m_Buffers) { buffer = UNKNOWN; }
+	m_ActiveTexture = UNKNOWN;
+	for (auto& unit : m_Textures)
+	{
+		for (unsigned int& texture : unit) { texture = UNKNOWN; }
+	}
+	for (int& capability : m_Capabilities) { capability = -1; }
+	m_Viewport[0] = m_Viewport[1] = m_Viewport[2] = m_Viewport[3] = -1;
+	for (unsigned int& factor : m_BlendFactors) { factor = UNKNOWN; }
+	m_BlendEquation = UNKNOWN;
+}
+
+void GLStateCache::OnDeleteProgram(unsigned int program)
+{
+	if (m_Program == program) { m_Program = UNKNOWN; }
+}
+
+void GLStateCache::OnDeleteVertexArray(unsigned int vertexArray)
+{
+	if (m_VertexArray == vertexArray)
+	{
+		m_VertexArray = UNKNOWN;
+		m_Buffers[ELEMENT_ARRAY_BUFFER] = UNKNOWN;
+	}
+}
+
+void GLStateCache::OnDeleteBuffer(unsigned int buffer)
+{
+	for (unsigned int& bound : m_Buffers)
+	{
+		if (bound == buffer) { bound = UNKNOWN; }
+	}
+}
+
+void GLStateCache::OnBindBufferBase(unsigned int target, unsigned int buffer)
+{
+	int index = GetBufferTarget(target);
+	if (index >= 0) { m_Buffers[index] = buffer; }
+}
+
+void GLStateCache::OnDeleteTexture(unsigned int texture)
+{
+	for (auto& unit : m_Textures)
+	{
+		for (unsigned int& bound : unit)
+		{
+			if (bound == texture) { bound = UNKNOWN; }
+		}
+	}
+}
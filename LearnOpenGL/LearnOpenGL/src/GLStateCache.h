@@ -0,0 +1,76 @@
+#pragma once
+
+const unsigned int GL_STATE_CACHE_TEXTURE_UNITS = 32;
+
+struct GLStateCacheStats
+{
+	unsigned int Issued;	// calls that reached GL
+	unsigned int Skipped;	// calls dropped because the state was already set
+};
+
+// Shadows the bound GL state of one context so that redundant binds never reach the driver.
+// Code that changes GL state without going through the cache (e.g. the legacy ImGui path)
+// must be followed by Invalidate().
+class GLStateCache
+{
+private:
+	enum BufferTarget { ARRAY_BUFFER = 0, ELEMENT_ARRAY_BUFFER, UNIFORM_BUFFER, SHADER_STORAGE_BUFFER,
+		DRAW_INDIRECT_BUFFER, PIXEL_UNPACK_BUFFER, BUFFER_TARGET_COUNT };
+	enum TextureTarget { TEXTURE_2D = 0, TEXTURE_2D_ARRAY, TEXTURE_TARGET_COUNT };
+	enum Capability { BLEND = 0, DEPTH_TEST, CULL_FACE, SCISSOR_TEST, CAPABILITY_COUNT };
+
+	unsigned int m_Program;
+	unsigned int m_VertexArray;
+	unsigned int m_Buffers[BUFFER_TARGET_COUNT];
+	unsigned int m_ActiveTexture;
+	unsigned int m_Textures[GL_STATE_CACHE_TEXTURE_UNITS][TEXTURE_TARGET_COUNT];
+	int m_Capabilities[CAPABILITY_COUNT];
+	int m_Viewport[4];
+	unsigned int m_BlendFactors[4];	// source rgb, destination rgb, source alpha, destination alpha
+	unsigned int m_BlendEquation;
+	GLStateCacheStats m_Stats;
+
+	static int GetBufferTarget(unsigned int target);
+	static int GetTextureTarget(unsigned int target);
+	static int GetCapability(unsigned int capability);
+
+public:
+	GLStateCache();
+
+	// cache of the context current on the calling thread
+	static GLStateCache& Get();
+
+	void UseProgram(unsigned int program);
+	void BindVertexArray(unsigned int vertexArray);
+	void BindBuffer(unsigned int target, unsigned int buffer);
+	void ActiveTexture(unsigned int unit);
+	void BindTexture(unsigned int target, unsigned int texture);
+	void SetEnabled(unsigned int capability, bool enabled);
+	void SetViewport(int x, int y, int width, int height);
+	void SetBlendFunc(unsigned int source, unsigned int destination);
+	void SetBlendFuncSeparate(unsigned int sourceRGB, unsigned int destinationRGB, unsigned int sourceAlpha, unsigned int destinationAlpha);
+	void SetBlendEquation(unsigned int mode);
+
+	// Shadowed values for code that puts state back the way it found it without asking GL.
+	// IsEnabled is -1 and the getters return false when the cache doesn't know, e.g. after
+	// Invalidate(); setting the value once makes it known again.
+	int IsEnabled(unsigned int capability) const;
+	bool GetViewport(int* viewport) const;
+	// glBlendFuncSeparate order
+	bool GetBlendFuncSeparate(unsigned int* factors) const;
+	bool GetBlendEquation(unsigned int& mode) const;
+
+	// Forget all shadowed state, the next call of every kind goes to GL
+	void Invalidate();
+
+	// GL unbinds deleted objects and recycles their names, so the cache has to forget them too
+	void OnDeleteProgram(unsigned int program);
+	void OnDeleteVertexArray(unsigned int vertexArray);
+	void OnDeleteBuffer(unsigned int buffer);
+	void OnDeleteTexture(unsigned int texture);
+	// glBindBufferBase/Range also replace the generic binding of the target
+	void OnBindBufferBase(unsigned int target, unsigned int buffer);
+
+	inline const GLStateCacheStats& GetStats() const { return m_Stats; }
+	inline void ResetStats() { m_Stats = { 0, 0 }; }
+};
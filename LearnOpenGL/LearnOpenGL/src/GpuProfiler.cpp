@@ -0,0 +1,199 @@
+#include "GpuProfiler.h"
+#include "Renderer.h"
+#include "StatsOverlay.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <fstream>
+
+#include "imgui/imgui.h"
+
+GpuProfiler::GpuProfiler()
+	: m_FrameIndex(0), m_HistoryOffset(0), m_LastFrameStart(0.0)
+{
+	for (FrameQueries& frame : m_Frames)
+	{
+		frame.Used = 0;
+		frame.Pending = false;
+	}
+	std::fill(m_GpuHistory, m_GpuHistory + GPU_PROFILER_HISTORY, 0.0f);
+	std::fill(m_CpuHistory, m_CpuHistory + GPU_PROFILER_HISTORY, 0.0f);
+}
+
+GpuProfiler::~GpuProfiler()
+{
+	for (FrameQueries& frame : m_Frames)
+	{
+		if (!frame.Pool.empty())
+		{
+			GLCall(glDeleteQueries((GLsizei)frame.Pool.size(), frame.Pool.data()));
+		}
+	}
+}
+
+unsigned int GpuProfiler::AcquireQuery(FrameQueries& frame)
+{
+	if (frame.Used == frame.Pool.size())
+	{
+		unsigned int query;
+		GLCall(glGenQueries(1, &query));
+		frame.Pool.push_back(query);
+	}
+	return frame.Pool[frame.Used++];
+}
+
+void GpuProfiler::ReadBack(FrameQueries& frame)
+{
+	if (!frame.Pending || frame.Scopes.empty()) { return; }
+	frame.Pending = false;
+
+	// the root scope ends last, if it isn't done we'd rather drop the frame than wait
+	GLint available = 0;
+	GLCall(glGetQueryObjectiv(frame.Scopes[0].EndQuery, GL_QUERY_RESULT_AVAILABLE, &available));
+	if (!available) { return; }
+
+	m_LastFrame.clear();
+	GLuint64 frameStart = 0;
+	for (size_t i = 0; i < frame.Scopes.size(); i++)
+	{
+		const QueryScope& scope = frame.Scopes[i];
+		GLuint64 begin, end;
+		GLCall(glGetQueryObjectui64v(scope.BeginQuery, GL_QUERY_RESULT, &begin));
+		GLCall(glGetQueryObjectui64v(scope.EndQuery, GL_QUERY_RESULT, &end));
+		if (i == 0) { frameStart = begin; }
+
+		double duration = (end - begin) / 1000000.0;
+		m_LastFrame.push_back({ scope.Name, scope.Depth, (begin - frameStart) / 1000000.0, duration });
+		SampleRing& samples = m_Samples[scope.Name];
+		if (samples.Values.size() < GPU_PROFILER_SAMPLES) { samples.Values.push_back((float)duration); }
+		else
+		{
+			samples.Values[samples.Next] = (float)duration;
+			samples.Next = (samples.Next + 1) % GPU_PROFILER_SAMPLES;
+		}
+	}
+	// BeginFrame has already moved the offset on, the newest sample goes next to the newest CPU one
+	m_GpuHistory[(m_HistoryOffset + GPU_PROFILER_HISTORY - 1) % GPU_PROFILER_HISTORY] = (float)m_LastFrame[0].DurationMs;
+}
+
+void GpuProfiler::BeginFrame()
+{
+	double now = glfwGetTime();
+	if (m_LastFrameStart > 0.0)
+	{
+		m_CpuHistory[m_HistoryOffset] = (float)((now - m_LastFrameStart) * 1000.0);
+		m_HistoryOffset = (m_HistoryOffset + 1) % GPU_PROFILER_HISTORY;
+	}
+	m_LastFrameStart = now;
+
+	m_FrameIndex = (m_FrameIndex + 1) % GPU_PROFILER_FRAMES;
+	FrameQueries& frame = m_Frames[m_FrameIndex];
+	ReadBack(frame);
+	frame.Scopes.clear();
+	frame.Used = 0;
+	m_Stack.clear();
+
+	BeginScope("Frame");
+}
+
+void GpuProfiler::EndFrame()
+{
+	// close anything left open, then the root scope
+	while (!m_Stack.empty())
+	{
+		EndScope();
+	}
+	m_Frames[m_FrameIndex].Pending = true;
+}
+
+void GpuProfiler::BeginScope(const char* name)
+{
+	FrameQueries& frame = m_Frames[m_FrameIndex];
+	unsigned int query = AcquireQuery(frame);
+	GLCall(glQueryCounter(query, GL_TIMESTAMP));
+
+	m_Stack.push_back((unsigned int)frame.Scopes.size());
+	frame.Scopes.push_back({ name, (unsigned int)m_Stack.size() - 1, query, 0 });
+}
+
+void GpuProfiler::EndScope()
+{
+	if (m_Stack.empty()) { return; }
+
+	FrameQueries& frame = m_Frames[m_FrameIndex];
+	unsigned int query = AcquireQuery(frame);
+	GLCall(glQueryCounter(query, GL_TIMESTAMP));
+
+	frame.Scopes[m_Stack.back()].EndQuery = query;
+	m_Stack.pop_back();
+}
+
+void GpuProfiler::OnImGuiRender()
+{
+	BeginStatsOverlay();
+
+	float gpuMs = m_LastFrame.empty() ? 0.0f : (float)m_LastFrame[0].DurationMs;
+	unsigned int latest = (m_HistoryOffset + GPU_PROFILER_HISTORY - 1) % GPU_PROFILER_HISTORY;
+	ImGui::Text("CPU frame %.3f ms, GPU frame %.3f ms", m_CpuHistory[latest], gpuMs);
+
+	// flame graph, one row per nesting level, scaled to the root scope
+	const float rowHeight = 18.0f;
+	unsigned int maxDepth = 0;
+	for (const ScopeResult& scope : m_LastFrame)
+	{
+		maxDepth = std::max(maxDepth, scope.Depth);
+	}
+
+	ImVec2 origin = ImGui::GetCursorScreenPos();
+	float width = ImGui::GetContentRegionAvailWidth();
+	ImGui::InvisibleButton("##flame", ImVec2(width, rowHeight * (maxDepth + 1)));
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+	ImVec2 mouse = ImGui::GetIO().MousePos;
+
+	double scale = gpuMs > 0.0f ? width / gpuMs : 0.0;
+	for (const ScopeResult& scope : m_LastFrame)
+	{
+		ImVec2 min(origin.x + (float)(scope.StartMs * scale), origin.y + scope.Depth * rowHeight);
+		ImVec2 max(min.x + std::max(1.0f, (float)(scope.DurationMs * scale)), min.y + rowHeight - 1.0f);
+		ImU32 color = ImGui::GetColorU32(ImVec4(0.9f - 0.15f * scope.Depth, 0.45f + 0.1f * scope.Depth, 0.2f, 1.0f));
+		drawList->AddRectFilled(min, max, color);
+
+		if (max.x - min.x > ImGui::CalcTextSize(scope.Name).x + 4.0f)
+		{
+			drawList->AddText(ImVec2(min.x + 2.0f, min.y + 2.0f), IM_COL32(0, 0, 0, 255), scope.Name);
+		}
+		if (mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y)
+		{
+			ImGui::SetTooltip("%s: %.3f ms", scope.Name, scope.DurationMs);
+		}
+	}
+
+	ImGui::PlotLines("GPU ms", m_GpuHistory, GPU_PROFILER_HISTORY, m_HistoryOffset, nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+	ImGui::PlotLines("CPU ms", m_CpuHistory, GPU_PROFILER_HISTORY, m_HistoryOffset, nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+
+	EndStatsOverlay();
+}
+
+bool GpuProfiler::DumpPercentiles(const std::string& path) const
+{
+	std::ofstream stream(path);
+	if (!stream) { return false; }
+
+	stream << "scope\tcount\tmean ms\tp50 ms\tp90 ms\tp99 ms\tmax ms\n";
+	for (const auto& entry : m_Samples)
+	{
+		std::vector<float> samples = entry.second.Values;
+		if (samples.empty()) { continue; }
+		std::sort(samples.begin(), samples.end());
+
+		double sum = 0.0;
+		for (float sample : samples) { sum += sample; }
+		auto percentile = [&](double p) { return samples[(size_t)(p * (samples.size() - 1))]; };
+
+		stream << entry.first << "\t" << samples.size() << "\t" << sum / samples.size() << "\t"
+			<< percentile(0.5) << "\t" << percentile(0.9) << "\t" << percentile(0.99) << "\t"
+			<< samples.back() << "\n";
+	}
+	return true;
+}
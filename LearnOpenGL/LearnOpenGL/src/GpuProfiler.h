@@ -0,0 +1,89 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// frames of queries in flight, results are read back this many frames late so we never stall
+const unsigned int GPU_PROFILER_FRAMES = 4;
+const unsigned int GPU_PROFILER_HISTORY = 240;
+// samples kept per scope for DumpPercentiles, the oldest are overwritten after that
+const unsigned int GPU_PROFILER_SAMPLES = 36000;
+
+// Times named, nested GPU scopes with GL_TIMESTAMP queries.
+// Scopes of a frame must be opened and closed between BeginFrame and EndFrame.
+class GpuProfiler
+{
+private:
+	struct QueryScope
+	{
+		const char* Name;
+		unsigned int Depth;
+		unsigned int BeginQuery;
+		unsigned int EndQuery;
+	};
+
+	struct FrameQueries
+	{
+		std::vector<QueryScope> Scopes;
+		std::vector<unsigned int> Pool;
+		unsigned int Used;
+		bool Pending;
+	};
+
+	struct ScopeResult
+	{
+		const char* Name;
+		unsigned int Depth;
+		double StartMs;
+		double DurationMs;
+	};
+
+	FrameQueries m_Frames[GPU_PROFILER_FRAMES];
+	unsigned int m_FrameIndex;
+	std::vector<unsigned int> m_Stack;
+
+	std::vector<ScopeResult> m_LastFrame;
+	float m_GpuHistory[GPU_PROFILER_HISTORY];
+	float m_CpuHistory[GPU_PROFILER_HISTORY];
+	unsigned int m_HistoryOffset;
+	double m_LastFrameStart;
+	struct SampleRing
+	{
+		std::vector<float> Values;
+		size_t Next;	// overwritten next once Values is full
+	};
+	std::unordered_map<std::string, SampleRing> m_Samples;
+
+	unsigned int AcquireQuery(FrameQueries& frame);
+	void ReadBack(FrameQueries& frame);
+
+public:
+	GpuProfiler();
+	~GpuProfiler();
+
+	void BeginFrame();
+	void EndFrame();
+	void BeginScope(const char* name);
+	void EndScope();
+
+	// Flame-style breakdown of the last resolved frame and rolling CPU/GPU frame times
+	void OnImGuiRender();
+	// Writes count, mean and p50/p90/p99/max per scope name, over the last GPU_PROFILER_SAMPLES frames
+	bool DumpPercentiles(const std::string& path) const;
+};
+
+class GpuProfileScope
+{
+private:
+	GpuProfiler& m_Profiler;
+
+public:
+	GpuProfileScope(GpuProfiler& profiler, const char* name)
+		: m_Profiler(profiler) { m_Profiler.BeginScope(name); }
+	~GpuProfileScope() { m_Profiler.EndScope(); }
+};
+
+#define GPU_PROFILE_SCOPE_CONCAT(a, b) a##b
+#define GPU_PROFILE_SCOPE_NAME(line) GPU_PROFILE_SCOPE_CONCAT(gpuProfileScope, line)
+#define GPU_PROFILE_SCOPE(profiler, name) GpuProfileScope GPU_PROFILE_SCOPE_NAME(__LINE__)(profiler, name)
@@ -1,26 +1,37 @@
 #include "IndexBuffer.h"
 #include "Renderer.h"
+#include "GLStateCache.h"
+#include "ResourceBackend.h"
 
 IndexBuffer::IndexBuffer(const unsigned int *data, unsigned int count)
 	: m_Count(count)
 {
 	ASSERT(sizeof(unsigned int) == sizeof(GLuint));
+	if (UseDirectStateAccess())
+	{
+		// creating it doesn't bind it, so it can't land in whatever VAO is bound either
+		GLCall(glCreateBuffers(1, &m_RendererID));
+		GLCall(glNamedBufferStorage(m_RendererID, count * sizeof(unsigned int), data, 0));
+		return;
+	}
+
 	GLCall(glGenBuffers(1, &m_RendererID));
-	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
+	GLStateCache::Get().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID);
 	GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_STATIC_DRAW));
 }
 
 IndexBuffer::~IndexBuffer()
 {
+	GLStateCache::Get().OnDeleteBuffer(m_RendererID);
 	GLCall(glDeleteBuffers(1, &m_RendererID));
 }
 
 void IndexBuffer::Bind() const
 {
-	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
+	GLStateCache::Get().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID);
 }
 
 void IndexBuffer::Unbind() const
 {
-	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+	GLStateCache::Get().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
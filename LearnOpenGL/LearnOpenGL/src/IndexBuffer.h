@@ -14,4 +14,5 @@ public:
 	void Unbind() const;
 
 	inline unsigned int GetCount() const { return m_Count;  }
+	inline unsigned int GetRendererID() const { return m_RendererID; }
 };
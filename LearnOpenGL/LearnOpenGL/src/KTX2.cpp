@@ -0,0 +1,234 @@
+#include "KTX2.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+static const unsigned char KTX2_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+// identifier + 9 header words + the index
+static const unsigned int KTX2_LEVEL_INDEX_OFFSET = 12 + 9 * 4 + 4 * 4 + 2 * 8;
+static const unsigned int KTX2_LEVEL_INDEX_SIZE = 3 * 8;
+
+// VkFormat values
+static const uint32_t VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131;
+static const uint32_t VK_FORMAT_BC3_UNORM_BLOCK = 137;
+static const uint32_t VK_FORMAT_BC7_UNORM_BLOCK = 145;
+
+// Khronos data format descriptor values
+static const uint8_t KHR_DF_MODEL_BC1A = 128;
+static const uint8_t KHR_DF_MODEL_BC3 = 130;
+static const uint8_t KHR_DF_MODEL_BC7 = 134;
+static const uint8_t KHR_DF_PRIMARIES_BT709 = 1;
+static const uint8_t KHR_DF_TRANSFER_LINEAR = 1;
+static const uint8_t KHR_DF_CHANNEL_COLOR = 0;
+static const uint8_t KHR_DF_CHANNEL_ALPHA = 15;
+
+static uint32_t GetVkFormat(BlockFormat format)
+{
+	switch (format)
+	{
+		case BlockFormat::BC1: return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+		case BlockFormat::BC3: return VK_FORMAT_BC3_UNORM_BLOCK;
+		case BlockFormat::BC7: return VK_FORMAT_BC7_UNORM_BLOCK;
+	}
+	return 0;
+}
+
+static void Append32(std::vector<unsigned char>& data, uint32_t value)
+{
+	for (int i = 0; i < 4; i++) { data.push_back((value >> (8 * i)) & 0xFF); }
+}
+
+static void Append64(std::vector<unsigned char>& data, uint64_t value)
+{
+	for (int i = 0; i < 8; i++) { data.push_back((value >> (8 * i)) & 0xFF); }
+}
+
+static void Pad(std::vector<unsigned char>& data, size_t alignment)
+{
+	while (data.size() % alignment != 0) { data.push_back(0); }
+}
+
+static uint32_t Read32(const unsigned char* data)
+{
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static uint64_t Read64(const unsigned char* data)
+{
+	return Read32(data) | ((uint64_t)Read32(data + 4) << 32);
+}
+
+// Basic descriptor block, one sample per 64 bits of the block
+static std::vector<unsigned char> MakeDataFormatDescriptor(BlockFormat format)
+{
+	struct Sample { uint16_t BitOffset; uint8_t BitLength; uint8_t Channel; };
+	std::vector<Sample> samples;
+	uint8_t model = KHR_DF_MODEL_BC1A;
+	switch (format)
+	{
+		case BlockFormat::BC1:
+			samples = { { 0, 64, KHR_DF_CHANNEL_COLOR } };
+			break;
+		case BlockFormat::BC3:
+			model = KHR_DF_MODEL_BC3;
+			samples = { { 0, 64, KHR_DF_CHANNEL_ALPHA }, { 64, 64, KHR_DF_CHANNEL_COLOR } };
+			break;
+		case BlockFormat::BC7:
+			model = KHR_DF_MODEL_BC7;
+			samples = { { 0, 128, KHR_DF_CHANNEL_COLOR } };
+			break;
+	}
+
+	uint32_t blockSize = 24 + 16 * (uint32_t)samples.size();
+	std::vector<unsigned char> dfd;
+	Append32(dfd, 4 + blockSize);
+	Append32(dfd, 0);						// vendor Khronos, type basic
+	Append32(dfd, 2 | (blockSize << 16));	// version 2
+	dfd.push_back(model);
+	dfd.push_back(KHR_DF_PRIMARIES_BT709);
+	dfd.push_back(KHR_DF_TRANSFER_LINEAR);
+	dfd.push_back(0);						// flags, straight alpha
+	dfd.insert(dfd.end(), { 3, 3, 0, 0 });	// 4x4x1x1 texel blocks, stored minus one
+	dfd.push_back((unsigned char)GetBlockSize(format));
+	dfd.insert(dfd.end(), 7, 0);
+	for (const Sample& sample : samples)
+	{
+		dfd.push_back(sample.BitOffset & 0xFF);
+		dfd.push_back(sample.BitOffset >> 8);
+		dfd.push_back(sample.BitLength - 1);
+		dfd.push_back(sample.Channel);
+		Append32(dfd, 0);					// sample position
+		Append32(dfd, 0);
+		Append32(dfd, 0xFFFFFFFF);
+	}
+	return dfd;
+}
+
+bool WriteKTX2(const std::string& path, const KTX2Image& image)
+{
+	uint32_t levelCount = (uint32_t)image.Levels.size();
+	std::vector<unsigned char> dfd = MakeDataFormatDescriptor(image.Format);
+	// bottom up rows, see KTX2.h
+	const char orientation[] = "KTXorientation\0ru";
+	std::vector<unsigned char> kvd;
+	Append32(kvd, sizeof(orientation));
+	kvd.insert(kvd.end(), orientation, orientation + sizeof(orientation));
+	Pad(kvd, 4);
+
+	uint32_t dfdOffset = KTX2_LEVEL_INDEX_OFFSET + KTX2_LEVEL_INDEX_SIZE * levelCount;
+	uint32_t kvdOffset = dfdOffset + (uint32_t)dfd.size();
+
+	std::vector<unsigned char> file(KTX2_IDENTIFIER, KTX2_IDENTIFIER + sizeof(KTX2_IDENTIFIER));
+	Append32(file, GetVkFormat(image.Format));
+	Append32(file, 1);						// typeSize
+	Append32(file, image.Width);
+	Append32(file, image.Height);
+	Append32(file, 0);						// depth
+	Append32(file, 0);						// layers, not an array
+	Append32(file, 1);						// faces
+	Append32(file, levelCount);
+	Append32(file, 0);						// no supercompression
+	Append32(file, dfdOffset);
+	Append32(file, (uint32_t)dfd.size());
+	Append32(file, kvdOffset);
+	Append32(file, (uint32_t)kvd.size());
+	Append64(file, 0);						// no supercompression global data
+	Append64(file, 0);
+
+	// levels go smallest first, each aligned to a whole block
+	size_t levelIndex = file.size();
+	file.resize(file.size() + KTX2_LEVEL_INDEX_SIZE * levelCount);
+	file.insert(file.end(), dfd.begin(), dfd.end());
+	file.insert(file.end(), kvd.begin(), kvd.end());
+	for (uint32_t level = levelCount; level-- > 0;)
+	{
+		Pad(file, GetBlockSize(image.Format));
+		std::vector<unsigned char> entry;
+		Append64(entry, file.size());
+		Append64(entry, image.Levels[level].size());
+		Append64(entry, image.Levels[level].size());
+		std::copy(entry.begin(), entry.end(), file.begin() + levelIndex + KTX2_LEVEL_INDEX_SIZE * level);
+		file.insert(file.end(), image.Levels[level].begin(), image.Levels[level].end());
+	}
+
+	std::ofstream stream(path, std::ios::binary);
+	stream.write((const char*)file.data(), file.size());
+	return (bool)stream;
+}
+
+bool ReadKTX2(const std::string& path, KTX2Image& image, std::string& error)
+{
+	std::ifstream stream(path, std::ios::binary);
+	if (!stream)
+	{
+		error = "can't open file";
+		return false;
+	}
+	std::vector<unsigned char> file((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+	if (file.size() < KTX2_LEVEL_INDEX_OFFSET || std::memcmp(file.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+	{
+		error = "not a KTX2 file";
+		return false;
+	}
+
+	const unsigned char* header = file.data() + sizeof(KTX2_IDENTIFIER);
+	uint32_t vkFormat = Read32(header);
+	if (vkFormat == VK_FORMAT_BC1_RGB_UNORM_BLOCK) { image.Format = BlockFormat::BC1; }
+	else if (vkFormat == VK_FORMAT_BC3_UNORM_BLOCK) { image.Format = BlockFormat::BC3; }
+	else if (vkFormat == VK_FORMAT_BC7_UNORM_BLOCK) { image.Format = BlockFormat::BC7; }
+	else
+	{
+		error = "unsupported vkFormat " + std::to_string(vkFormat);
+		return false;
+	}
+
+	image.Width = (int)Read32(header + 8);
+	image.Height = (int)Read32(header + 12);
+	uint32_t depth = Read32(header + 16), layers = Read32(header + 20), faces = Read32(header + 24);
+	// 0 levels asks the loader to generate them, we just take the one that's there
+	uint32_t levelCount = std::max(1u, Read32(header + 28));
+	uint32_t supercompression = Read32(header + 32);
+	if (depth != 0 || layers > 1 || faces != 1 || supercompression != 0 || image.Width <= 0 || image.Height <= 0)
+	{
+		error = "only plain 2D textures are supported";
+		return false;
+	}
+	// bigger than GL_MAX_TEXTURE_SIZE anywhere, and past it level sizes overflow GetCompressedSize
+	if (image.Width > 32768 || image.Height > 32768)
+	{
+		error = "too large";
+		return false;
+	}
+	// a full chain ends at 1x1, more levels than that would shift the size by 32 or more
+	uint32_t maxLevels = 1;
+	while ((std::max(image.Width, image.Height) >> maxLevels) > 0) { maxLevels++; }
+	if (levelCount > maxLevels)
+	{
+		error = std::to_string(levelCount) + " levels for a " + std::to_string(image.Width) + "x" + std::to_string(image.Height) + " image";
+		return false;
+	}
+	if (file.size() < KTX2_LEVEL_INDEX_OFFSET + (size_t)KTX2_LEVEL_INDEX_SIZE * levelCount)
+	{
+		error = "truncated level index";
+		return false;
+	}
+
+	image.Levels.resize(levelCount);
+	for (uint32_t level = 0; level < levelCount; level++)
+	{
+		const unsigned char* entry = file.data() + KTX2_LEVEL_INDEX_OFFSET + KTX2_LEVEL_INDEX_SIZE * level;
+		uint64_t offset = Read64(entry), length = Read64(entry + 8);
+		int width = std::max(1, image.Width >> level), height = std::max(1, image.Height >> level);
+		// offset + length could wrap around
+		if (length != GetCompressedSize(image.Format, width, height) || offset > file.size() || length > file.size() - offset)
+		{
+			error = "bad level " + std::to_string(level);
+			return false;
+		}
+		image.Levels[level].assign(file.begin() + (size_t)offset, file.begin() + (size_t)(offset + length));
+	}
+	return true;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "BlockCompression.h"
+
+// The subset of KTX2 (https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html) the
+// cooker writes and Texture reads: one 2D image, BC1/BC3/BC7 unorm, a full or partial mip
+// chain, no supercompression. Rows are stored bottom up like stb_image flips them, the
+// KTXorientation key says so.
+struct KTX2Image
+{
+	BlockFormat Format;
+	int Width, Height;
+	std::vector<std::vector<unsigned char>> Levels;	// level 0 is full size
+};
+
+bool WriteKTX2(const std::string& path, const KTX2Image& image);
+// Returns false and fills error when the file is missing, malformed or not one of our formats
+bool ReadKTX2(const std::string& path, KTX2Image& image, std::string& error);
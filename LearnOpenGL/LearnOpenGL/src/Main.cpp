@@ -1,6 +1,7 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -12,6 +13,23 @@
 #include "VertexBufferLayout.h"
 #include "Shader.h"
 #include "Texture.h"
+#include "RenderQueue.h"
+#include "GLStateCache.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include "CubeScene.h"
+#include "Benchmark.h"
+#include "ProgramCache.h"
+#include "ShaderLibrary.h"
+#include "TextureStreamer.h"
+#include "TextureCooker.h"
+#include "ResourceManager.h"
+#include "ResourceBackend.h"
+#include "StreamBuffer.h"
+#include "UiCache.h"
+#include "FrameScheduler.h"
+
+#include "stb_image/stb_image.h"
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
@@ -27,19 +45,43 @@ const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 
 // main
-int main(void)
+int main(int argc, char** argv)
 {
+	// Every stb_image decode is flipped to GL's bottom up rows. The flag is an unsynchronized
+	// global that the TextureStreamer workers read, so it's set once here, before any of them
+	// start, and never touched again.
+	stbi_set_flip_vertically_on_load(1);
+
+	// "--cook <image>" writes a compressed KTX2 file, no window needed
+	CookOptions cook;
+	if (ParseCookOptions(argc, argv, cook)) { return RunCooker(cook); }
+
 	/* Initialize the library */
 	if (!glfwInit()) { return -1; }
 
+	// Benchmarks run offscreen instead of the interactive scene
+	BenchmarkOptions benchmark;
+	bool benchmarking = ParseBenchmarkOptions(argc, argv, benchmark);
+
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 4);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#if GL_ERROR_CHECK != GL_ERROR_CHECK_NONE
+	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+#endif
 
 #ifdef __APPLE__
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // uncomment to compile on osx
 #endif
 
+	if (benchmarking)
+	{
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		// EGL context on the hidden window, e.g. Mesa llvmpipe under Xvfb. GLFW still needs
+		// X11 or Wayland to make the window, this isn't a surfaceless context.
+		if (benchmark.Egl) { glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API); }
+	}
+
 	// GLFW window creation
 	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Learn OpenGL", NULL, NULL);
 	if (!window)
@@ -61,6 +103,44 @@ int main(void)
 	}
 
 	std::cout << glGetString(GL_VERSION) << "\n";
+	GLDebugInit();
+
+	// "--no-dsa" keeps resources on the bind-to-edit path even when the context has GL 4.5
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::string(argv[i]) == "--no-dsa") { SetResourceBackend(ResourceBackend::BindToEdit); }
+	}
+	std::cout << "Resource backend: " << GetResourceBackendName(GetResourceBackend()) << "\n";
+
+	// "--trace <file>" records CPU zones into a Chrome trace
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (std::string(argv[i]) == "--trace") { CpuProfiler::BeginSession(argv[i + 1]); }
+	}
+	// "--no-program-cache" always compiles shaders from source, "--no-warmup" skips the warm-up pass,
+	// "--retained-ui" starts with the UI cached, "--event-driven" only draws when something changed
+	// or "--max-idle <seconds>" passed, "--no-animation" starts with the cubes still (all of them
+	// can be toggled in the overlay too)
+	bool warmUp = true, retainedUi = false, eventDriven = false, animate = true;
+	double maxIdle = FRAME_SCHEDULER_MAX_IDLE;
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::string(argv[i]) == "--no-program-cache") { ProgramCache::SetDirectory(""); }
+		if (std::string(argv[i]) == "--no-warmup") { warmUp = false; }
+		if (std::string(argv[i]) == "--retained-ui") { retainedUi = true; }
+		if (std::string(argv[i]) == "--event-driven") { eventDriven = true; }
+		if (std::string(argv[i]) == "--no-animation") { animate = false; }
+		if (std::string(argv[i]) == "--max-idle" && i + 1 < argc) { maxIdle = std::stod(argv[i + 1]); }
+	}
+
+	if (benchmarking)
+	{
+		int result = RunBenchmark(window, benchmark);
+		CpuProfiler::EndSession();
+		GLDebugShutdown();
+		glfwTerminate();
+		return result;
+	}
 
 	{
 		// Setup vertex data (and buffer(s)) and configure vertex attributes
@@ -87,81 +167,15 @@ int main(void)
 			-0.5f,  0.5f, -0.5f,   0.0f, 1.0f  // back top left 
 		};
 		*/
-		float vertices[] = {
-			-0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
-			0.5f, -0.5f, -0.5f,  1.0f, 0.0f,
-			0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-			0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-			-0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
-			-0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
-
-			-0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-			0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-			0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
-			0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
-			-0.5f,  0.5f,  0.5f,  0.0f, 1.0f,
-			-0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-
-			-0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-			-0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-			-0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-			-0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-			-0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-			-0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-
-			0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-			0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-			0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-			0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-			0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-			0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-
-			-0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-			0.5f, -0.5f, -0.5f,  1.0f, 1.0f,
-			0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-			0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-			-0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-			-0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-
-			-0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
-			0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-			0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-			0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-			-0.5f,  0.5f,  0.5f,  0.0f, 0.0f,
-			-0.5f,  0.5f, -0.5f,  0.0f, 1.0f
-		};
 		unsigned int indices[] = {
 			0, 1, 3, // first triangle
 			1, 2, 3  // second triangle
 		};
 
-		// More cubes positions
-		glm::vec3 cubePositions[] = {
-			glm::vec3(0.0f,  0.0f,  0.0f),
-			glm::vec3(2.0f,  5.0f, -15.0f),
-			glm::vec3(-1.5f, -2.2f, -2.5f),
-			glm::vec3(-3.8f, -2.0f, -12.3f),
-			glm::vec3(2.4f, -0.4f, -3.5f),
-			glm::vec3(-1.7f,  3.0f, -7.5f),
-			glm::vec3(1.3f, -2.0f, -2.5f),
-			glm::vec3(1.5f,  2.0f, -2.5f),
-			glm::vec3(1.5f,  0.2f, -1.5f),
-			glm::vec3(-1.3f,  1.0f, -1.5f)
-		};
-
 		// Setup GL Blending
-		GLCall(glEnable(GL_BLEND));
-		GLCall(glEnable(GL_DEPTH_TEST));
-		GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
-
-		// Set up array buffer and vertex buffer
-		VertexArray va;
-		VertexBuffer vb(vertices, sizeof(vertices));
-
-		VertexBufferLayout layout;
-		layout.Push<float>(3); // positions
-		layout.Push<float>(2); // texture coords
-		va.AddBuffer(vb, layout);
+		GLStateCache::Get().SetEnabled(GL_BLEND, true);
+		GLStateCache::Get().SetEnabled(GL_DEPTH_TEST, true);
+		GLStateCache::Get().SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 		//IndexBuffer ib(indices, 12);
 
@@ -173,25 +187,73 @@ int main(void)
 		projection = glm::perspective(45.0f, (float)SCR_WIDTH/ (float)SCR_HEIGHT, 0.1f, 100.0f);
 		view = glm::translate(view, glm::vec3(0.0f, 0.0f, -3.0f));
 
-		// Build and compile our shader program
+		// Build the scene (shaders, cube vertex array and texture)
+		// the library outlives the scene, edits to shader files are picked up while running
 		Renderer renderer;
-		Shader shader("resources/shaders/Basic.shader");
-		shader.Bind();
-		shader.SetUniform1i("u_Texture", 0);
+		ShaderCompiler shaderCompiler;
+		ShaderLibrary shaderLibrary(shaderCompiler);
+		// decodes on worker threads, uploads a budgeted slice every frame
+		TextureStreamer textureStreamer;
+
+		// every program compiles at once, the window keeps drawing a loading frame meanwhile
+		CubeScene::PreloadShaders(shaderLibrary);
+		double loadingStart = glfwGetTime();
+		while (shaderLibrary.IsLoading())
+		{
+			shaderLibrary.Update();
+			GLCall(glClearColor(0.1f, 0.1f, 0.1f, 1.0f));
+			GLCall(glClear(GL_COLOR_BUFFER_BIT));
+			glfwSwapBuffers(window);
+			glfwPollEvents();
+		}
+		std::cout << "[ShaderCompiler] Programs ready in " << (glfwGetTime() - loadingStart) * 1000.0 << " ms ("
+			<< ShaderCompiler::GetModeName(shaderLibrary.GetCompiler().GetMode()) << ")\n";
+
+		// shared textures and shaders, textures nothing holds stay resident up to the budget
+		ResourceManager resources(shaderLibrary, &textureStreamer);
+		CubeScene scene(resources, 10);
 
-		// Texture stuff
-		Texture texture("resources/textures/fortnite.jpg");
-		texture.Bind();
+		// finish every program before the first frame instead of hitching on first use
+		if (warmUp) { ProgramCache::WarmUp(); }
+		const ProgramCacheStats& programStats = ProgramCache::GetStats();
+		std::cout << "[ProgramCache] " << programStats.Hits << " programs loaded (" << programStats.LoadMs << " ms), "
+			<< programStats.Misses << " compiled (" << programStats.CompileMs << " ms), "
+			<< "warm-up " << programStats.WarmUpMs << " ms\n";
 
 		// imgui
 		ImGui::CreateContext();
 		ImGui_ImplGlfwGL3_Init(window, true);
 		ImGui::StyleColorsDark();
+		// draws ImGui, or composites its last image while the UI doesn't change
+		UiCache uiCache(shaderLibrary, retainedUi);
+		// after ImGui's callbacks, it chains onto them
+		FrameScheduler scheduler(window, eventDriven, maxIdle);
 
 		// variables used in main loop
 		glm::vec3 translation(0.0f, 0.0f, 0.0f);
+		GpuProfiler profiler;
+		int drawMode = CubeScene::DRAW_INSTANCED;
+		// ImGui's framerate only counts frames that build the UI, the retained UI skips some
+		double lastFrameTime = glfwGetTime();
+		float frameMs = 16.0f;
+		// last frame's, the UI isn't built every frame
+		GLStateCacheStats cacheStats = { 0, 0 };
+		// advances only while the cubes animate
+		double sceneTime = 0.0;
 
 		while (!glfwWindowShouldClose(window)) {
+			// polls events, or sleeps until something needs drawing
+			if (!scheduler.WaitForFrame()) { continue; }
+
+			PROFILE_SCOPE("Main loop");
+			profiler.BeginFrame();
+			// swap in reloaded shaders between frames, never halfway through one
+			shaderLibrary.Update();
+			textureStreamer.Update();
+			resources.Update();
+			// changed shader files are only noticed on frames that are drawn, at least every max idle interval
+			if (textureStreamer.GetPendingCount() > 0) { scheduler.MarkDirty(FrameSource::AsyncLoad); }
+			if (shaderLibrary.IsLoading() || shaderLibrary.IsReloading()) { scheduler.MarkDirty(FrameSource::HotReload); }
 			glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 			//renderer.Clear();
@@ -199,49 +261,89 @@ int main(void)
 			// Matrix stuff
 			//model = glm::rotate(model, glm::radians(0.2f), glm::vec3(0.5f, 1.0f, 0.0f));
 
+			double frameTime = glfwGetTime();
+			frameMs = frameMs * 0.95f + (float)((frameTime - lastFrameTime) * 1000.0) * 0.05f;
+			if (animate)
+			{
+				// no jump after an idle stretch
+				sceneTime += std::min(frameTime - lastFrameTime, 0.1);
+				scheduler.MarkDirty(FrameSource::Animation);
+			}
+			lastFrameTime = frameTime;
+
 			// imgui
-			ImGui_ImplGlfwGL3_NewFrame();
+			bool buildUi = uiCache.BeginFrame(window);
+			if (buildUi) { ImGui_ImplGlfwGL3_NewFrame(); }
 
 			// Process input
 			processInput(window);
 
 			// Draw calls
-			//renderer.Draw(va, ib, shader);
-			//glDrawArrays(GL_TRIANGLES, 0, 36);
-			for (unsigned int i = 0; i < 10; i++)
 			{
-				glm::mat4 model(1.0f);
-				model = glm::translate(model, cubePositions[i]);
-				float angle = glfwGetTime() * 20.0f;
-				model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-
-				glm::mat4 mvp = projection * view * model;
-
-				shader.Bind();
-				shader.SetUniformMat4f("u_MVP", mvp);
-
-				glDrawArrays(GL_TRIANGLES, 0, 36);
+				PROFILE_SCOPE("Scene");
+				GPU_PROFILE_SCOPE(profiler, "Scene");
+				//renderer.Draw(va, ib, shader);
+				//glDrawArrays(GL_TRIANGLES, 0, 36);
+				float time = (float)sceneTime;
+				renderer.BeginScene(view, projection, time);
+				scene.Update(time);
+				scene.Draw(renderer, (CubeScene::DrawMode)drawMode, view);
 			}
 
 			// imgui window
+			if (buildUi)
 			{
 				ImGui::SliderFloat3("translation", &translation.x, 0.0f, 100.0f);
-				ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+				ImGui::RadioButton("loop", &drawMode, CubeScene::DRAW_LOOP); ImGui::SameLine();
+				ImGui::RadioButton("instanced", &drawMode, CubeScene::DRAW_INSTANCED); ImGui::SameLine();
+				ImGui::RadioButton("render queue", &drawMode, CubeScene::DRAW_QUEUE); ImGui::SameLine();
+				ImGui::RadioButton("multi draw", &drawMode, CubeScene::DRAW_MULTI);
+				ImGui::Checkbox("animate", &animate);
+				if (drawMode == CubeScene::DRAW_QUEUE || drawMode == CubeScene::DRAW_MULTI)
+				{
+					const RenderQueueStats& stats = scene.GetQueue().GetStats();
+					ImGui::Text("%u packets, %u state changes (%u saved)", stats.Packets, stats.StateChanges, stats.StateChangesSaved);
+					ImGui::Text("%u draw calls (%u collapsed)", stats.DrawCalls, stats.DrawsCollapsed);
+				}
+				ImGui::Text("GL state calls: %u issued, %u skipped", cacheStats.Issued, cacheStats.Skipped);
+				ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", frameMs, 1000.0f / frameMs);
+
+				profiler.OnImGuiRender();
+				shaderLibrary.OnImGuiRender();
+				textureStreamer.OnImGuiRender();
+				resources.OnImGuiRender();
+				renderer.GetStreamBuffer().OnImGuiRender();
+				uiCache.OnImGuiRender();
+				scheduler.OnImGuiRender();
 			}
 
-			// imgui render
-			ImGui::Render();
-			ImGui_ImplGlfwGL3_RenderDrawData(ImGui::GetDrawData());
+			// imgui render, the backend changes GL state through the state cache
+			{
+				GPU_PROFILE_SCOPE(profiler, "ImGui");
+				PROFILE_SCOPE("ImGui_ImplGlfwGL3_RenderDrawData");
+				if (buildUi) { ImGui::Render(); }
+				uiCache.Render(buildUi ? ImGui::GetDrawData() : nullptr);
+			}
+			profiler.EndFrame();
+			renderer.EndFrame();
+			cacheStats = GLStateCache::Get().GetStats();
+			GLStateCache::Get().ResetStats();
 
 			/* Swap front and back buffers and poll for IO events (keys, mouse, ect) */
-			glfwSwapBuffers(window);
-			glfwPollEvents();
+			{
+				PROFILE_SCOPE("glfwSwapBuffers");
+				glfwSwapBuffers(window);
+			}
+			PROFILE_FRAME_MARK();
 		}
+		profiler.DumpPercentiles("gpu_profile.txt");
 	}
 
 	// Terminate imgui
     ImGui_ImplGlfwGL3_Shutdown();
     ImGui::DestroyContext();
+	GLDebugShutdown();
+	CpuProfiler::EndSession();
 	// Terminate GLFW (clears all GLFW allocated resources)
 	glfwTerminate();
 
@@ -253,7 +355,7 @@ void framebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
 	// make sure the viewport matches the new window dimensions; note that width and
 	// height will be significantly larger than specified on a retina displays.
-	GLCall(glViewport(0, 0, width, height));
+	GLStateCache::Get().SetViewport(0, 0, width, height);
 }
 
 // Process all input: query GLFW whether relevant keys are pressed/released
@@ -0,0 +1,109 @@
+#include "Material.h"
+#include "Renderer.h"
+#include "Texture.h"
+#include "TextureTable.h"
+
+#include <cstring>
+#include <iostream>
+
+Material::Material(Shader& shader)
+	: m_Shader(shader), m_Program(shader.GetRendererID()), m_Textures(), m_TextureCount(0),
+	m_Table(nullptr), m_TableUnit(0)
+{
+}
+
+int Material::Resolve(UniformHandle handle, unsigned int type) const
+{
+	const ShaderUniform* uniform = m_Shader.FindUniform(handle);
+	if (!uniform) { return -1; }
+	if (!Shader::IsUniformTypeCompatible(uniform->Type, type))
+	{
+		std::cout << "[Material] " << m_Shader.GetFilepath() << ": wrong value type for uniform " << uniform->Name << std::endl;
+		return -1;
+	}
+	return uniform->Location;
+}
+
+void Material::SetValue(UniformHandle handle, unsigned int type, const void* value, unsigned int size)
+{
+	for (Entry& entry : m_Entries)
+	{
+		if (entry.Handle.Hash == handle.Hash && entry.Type == type)
+		{
+			std::memcpy(&m_Data[entry.Offset], value, size);
+			return;
+		}
+	}
+
+	// values the shader doesn't have are kept, a reload may add the uniform
+	Entry entry = { handle, Resolve(handle, type), type, (unsigned int)m_Data.size() };
+	m_Data.resize(m_Data.size() + size);
+	std::memcpy(&m_Data[entry.Offset], value, size);
+	m_Entries.push_back(entry);
+}
+
+void Material::Set(UniformHandle handle, int value) { SetValue(handle, GL_INT, &value, sizeof(value)); }
+void Material::Set(UniformHandle handle, float value) { SetValue(handle, GL_FLOAT, &value, sizeof(value)); }
+void Material::Set(UniformHandle handle, const glm::vec2& value) { SetValue(handle, GL_FLOAT_VEC2, &value, sizeof(value)); }
+void Material::Set(UniformHandle handle, const glm::vec3& value) { SetValue(handle, GL_FLOAT_VEC3, &value, sizeof(value)); }
+void Material::Set(UniformHandle handle, const glm::vec4& value) { SetValue(handle, GL_FLOAT_VEC4, &value, sizeof(value)); }
+void Material::Set(UniformHandle handle, const glm::mat4& value) { SetValue(handle, GL_FLOAT_MAT4, &value, sizeof(value)); }
+
+void Material::SetTexture(UniformHandle handle, const Texture& texture)
+{
+	ASSERT(m_TextureCount < MATERIAL_MAX_TEXTURES);
+	m_Textures[m_TextureCount] = &texture;
+	Set(handle, (int)m_TextureCount);
+	m_TextureCount++;
+}
+
+void Material::SetTextureTable(UniformHandle indexHandle, const TextureTable& table, unsigned int index)
+{
+	SetTextureTable(table);
+	Set(indexHandle, (int)index);
+}
+
+void Material::SetTextureTable(const TextureTable& table)
+{
+	static constexpr UniformHandle TEXTURE_ARRAY_UNIFORM("u_TextureArray");
+
+	if (!m_Table && table.GetMode() == TextureTable::MODE_ARRAY)
+	{
+		ASSERT(m_TextureCount < MATERIAL_MAX_TEXTURES);
+		m_TableUnit = m_TextureCount++;
+		Set(TEXTURE_ARRAY_UNIFORM, (int)m_TableUnit);
+	}
+	m_Table = &table;
+}
+
+void Material::Apply()
+{
+	m_Shader.Bind();
+	if (m_Program != m_Shader.GetRendererID())
+	{
+		m_Program = m_Shader.GetRendererID();
+		for (Entry& entry : m_Entries) { entry.Location = Resolve(entry.Handle, entry.Type); }
+	}
+
+	for (unsigned int unit = 0; unit < m_TextureCount; unit++)
+	{
+		if (m_Textures[unit]) { m_Textures[unit]->Bind(unit); }
+	}
+	if (m_Table) { m_Table->Bind(m_TableUnit); }
+
+	for (const Entry& entry : m_Entries)
+	{
+		if (entry.Location == -1) { continue; }
+
+		const void* value = &m_Data[entry.Offset];
+		switch (entry.Type)
+		{
+			case GL_INT: GLCall(glUniform1iv(entry.Location, 1, (const int*)value)); break;
+			case GL_FLOAT: GLCall(glUniform1fv(entry.Location, 1, (const float*)value)); break;
+			case GL_FLOAT_VEC2: GLCall(glUniform2fv(entry.Location, 1, (const float*)value)); break;
+			case GL_FLOAT_VEC3: GLCall(glUniform3fv(entry.Location, 1, (const float*)value)); break;
+			case GL_FLOAT_VEC4: GLCall(glUniform4fv(entry.Location, 1, (const float*)value)); break;
+			case GL_FLOAT_MAT4: GLCall(glUniformMatrix4fv(entry.Location, 1, GL_FALSE, (const float*)value)); break;
+		}
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+
+#include "Shader.h"
+
+class Texture;
+class TextureTable;
+
+const unsigned int MATERIAL_MAX_TEXTURES = 8;
+
+// A shader plus the values of its uniforms. Values are resolved against the shader's
+// reflection table when they are set and Apply uploads all of them in one pass, with no
+// lookups. A hot reload that swaps the program is noticed and resolved again.
+class Material
+{
+private:
+	struct Entry
+	{
+		UniformHandle Handle;
+		int Location;
+		unsigned int Type;		// GL type of the value as set
+		unsigned int Offset;	// into m_Data
+	};
+
+	Shader& m_Shader;
+	unsigned int m_Program;
+	std::vector<Entry> m_Entries;
+	std::vector<unsigned char> m_Data;
+	const Texture* m_Textures[MATERIAL_MAX_TEXTURES];
+	unsigned int m_TextureCount;
+	const TextureTable* m_Table;
+	unsigned int m_TableUnit;
+
+	void SetValue(UniformHandle handle, unsigned int type, const void* value, unsigned int size);
+	int Resolve(UniformHandle handle, unsigned int type) const;
+
+public:
+	Material(Shader& shader);
+
+	void Set(UniformHandle handle, int value);
+	void Set(UniformHandle handle, float value);
+	void Set(UniformHandle handle, const glm::vec2& value);
+	void Set(UniformHandle handle, const glm::vec3& value);
+	void Set(UniformHandle handle, const glm::vec4& value);
+	void Set(UniformHandle handle, const glm::mat4& value);
+	// Gives the texture the next free unit and points the sampler at it
+	void SetTexture(UniformHandle handle, const Texture& texture);
+	// Textures come out of the table by index, set through the index uniform. The table
+	// takes a unit of its own in array mode, in bindless mode it binds its handle block.
+	void SetTextureTable(UniformHandle indexHandle, const TextureTable& table, unsigned int index);
+	// Just binds the table, for shaders that get their indices elsewhere (an SSBO per instance)
+	void SetTextureTable(const TextureTable& table);
+
+	// Binds the shader and textures and uploads every value
+	void Apply();
+
+	inline Shader& GetShader() const { return m_Shader; }
+};
@@ -0,0 +1,221 @@
+#include "ProgramCache.h"
+#include "Renderer.h"
+#include "GLStateCache.h"
+#include "CpuProfiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+static const uint32_t PROGRAM_CACHE_MAGIC = 0x42505347; // "GSPB"
+
+struct ProgramBinaryHeader
+{
+	uint32_t Magic;
+	uint32_t Format;
+	uint64_t Key;
+};
+
+std::string ProgramCache::s_Directory = "shader_cache";
+std::vector<unsigned int> ProgramCache::s_Programs;
+ProgramCacheStats ProgramCache::s_Stats = {};
+
+static double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// FNV-1a, 64 bit
+static uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+static std::string GetEntryPath(const std::string& directory, uint64_t key)
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+	return (fs::path(directory) / name).string();
+}
+
+static bool IsFormatSupported(unsigned int format)
+{
+	int count = 0;
+	GLCall(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count));
+	if (count <= 0) { return false; }
+
+	std::vector<int> formats(count);
+	GLCall(glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data()));
+	return std::find(formats.begin(), formats.end(), (int)format) != formats.end();
+}
+
+void ProgramCache::SetDirectory(const std::string& directory)
+{
+	s_Directory = directory;
+}
+
+void ProgramCache::Clear()
+{
+	if (s_Directory.empty()) { return; }
+
+	std::error_code error;
+	for (const auto& entry : fs::directory_iterator(s_Directory, error))
+	{
+		if (entry.path().extension() == ".bin") { fs::remove(entry.path(), error); }
+	}
+}
+
+uint64_t ProgramCache::MakeKey(const std::vector<std::string>& sources, const std::string& defines)
+{
+	// the driver identity only changes between runs, hash it once
+	static const uint64_t driverHash = []()
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+		{
+			const char* value = (const char*)glGetString(name);
+			if (value) { hash = HashBytes(value, std::strlen(value), hash); }
+		}
+		return hash;
+	}();
+
+	uint64_t hash = HashBytes(defines.data(), defines.size(), driverHash);
+	for (const std::string& source : sources)
+	{
+		// the separator keeps "ab" + "c" and "a" + "bc" apart
+		hash = HashBytes(source.data(), source.size(), hash);
+		hash = HashBytes("\0", 1, hash);
+	}
+	return hash;
+}
+
+unsigned int ProgramCache::Load(uint64_t key)
+{
+	if (s_Directory.empty()) { return 0; }
+	PROFILE_FUNCTION();
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::string path = GetEntryPath(s_Directory, key);
+	std::ifstream file(path, std::ios::binary);
+	if (!file) { return 0; }
+
+	ProgramBinaryHeader header = {};
+	file.read((char*)&header, sizeof(header));
+	std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	file.close();
+
+	// a binary from another driver build is only rejected after glProgramBinary,
+	// but an unknown format would raise GL_INVALID_ENUM so check that first
+	bool valid = header.Magic == PROGRAM_CACHE_MAGIC && header.Key == key && !binary.empty()
+		&& IsFormatSupported(header.Format);
+
+	unsigned int program = 0;
+	if (valid)
+	{
+		GLCall(program = glCreateProgram());
+		GLCall(glProgramBinary(program, header.Format, binary.data(), (GLsizei)binary.size()));
+
+		int success = 0;
+		GLCall(glGetProgramiv(program, GL_LINK_STATUS, &success));
+		if (!success)
+		{
+			GLCall(glDeleteProgram(program));
+			program = 0;
+		}
+	}
+
+	if (program == 0)
+	{
+		std::cout << "[ProgramCache] Rejected " << path << ", recompiling" << std::endl;
+		std::error_code error;
+		fs::remove(path, error);
+		s_Stats.Rejected++;
+		return 0;
+	}
+
+	s_Programs.push_back(program);
+	s_Stats.Hits++;
+	s_Stats.LoadMs += MillisecondsSince(start);
+	return program;
+}
+
+void ProgramCache::Store(uint64_t key, unsigned int program)
+{
+	s_Programs.push_back(program);
+	s_Stats.Misses++;
+	if (s_Directory.empty()) { return; }
+
+	int length = 0;
+	GLCall(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+	if (length <= 0) { return; }
+
+	ProgramBinaryHeader header = { PROGRAM_CACHE_MAGIC, 0, key };
+	std::vector<char> binary(length);
+	GLCall(glGetProgramBinary(program, length, nullptr, (GLenum*)&header.Format, binary.data()));
+
+	std::error_code error;
+	fs::create_directories(s_Directory, error);
+
+	// write to a temporary file first so a crash never leaves a truncated entry behind
+	std::string path = GetEntryPath(s_Directory, key);
+	std::string temporary = path + ".tmp";
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			std::cout << "[ProgramCache] Can't write " << temporary << std::endl;
+			return;
+		}
+		file.write((const char*)&header, sizeof(header));
+		file.write(binary.data(), binary.size());
+	}
+	fs::rename(temporary, path, error);
+}
+
+void ProgramCache::AddCompileTime(double ms)
+{
+	s_Stats.CompileMs += ms;
+}
+
+void ProgramCache::WarmUp()
+{
+	if (s_Programs.empty()) { return; }
+	PROFILE_FUNCTION();
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// attribute-less draw with rasterization off: nothing reaches the framebuffer
+	unsigned int vertexArray;
+	GLCall(glGenVertexArrays(1, &vertexArray));
+	GLStateCache& cache = GLStateCache::Get();
+	cache.BindVertexArray(vertexArray);
+	GLCall(glEnable(GL_RASTERIZER_DISCARD));
+	for (unsigned int program : s_Programs)
+	{
+		cache.UseProgram(program);
+		GLCall(glDrawArrays(GL_TRIANGLES, 0, 3));
+	}
+	GLCall(glDisable(GL_RASTERIZER_DISCARD));
+	cache.UseProgram(0);
+	cache.BindVertexArray(0);
+	cache.OnDeleteVertexArray(vertexArray);
+	GLCall(glDeleteVertexArrays(1, &vertexArray));
+	GLCall(glFinish());
+
+	s_Stats.WarmUpMs += MillisecondsSince(start);
+}
+
+void ProgramCache::OnDeleteProgram(unsigned int program)
+{
+	s_Programs.erase(std::remove(s_Programs.begin(), s_Programs.end(), program), s_Programs.end());
+}
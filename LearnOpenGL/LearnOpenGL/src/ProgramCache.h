@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ProgramCacheStats
+{
+	unsigned int Hits;		// programs loaded from a stored binary
+	unsigned int Misses;	// programs compiled from source
+	unsigned int Rejected;	// binaries the driver refused, compiled from source instead
+	double LoadMs;			// time spent in glProgramBinary
+	double CompileMs;		// time spent compiling and linking
+	double WarmUpMs;
+};
+
+// On-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary).
+// Entries are keyed on the sources, the defines and the driver, so a driver update
+// or a shader edit just misses. An empty directory disables the cache.
+class ProgramCache
+{
+public:
+	static void SetDirectory(const std::string& directory);
+	inline static const std::string& GetDirectory() { return s_Directory; }
+	// Deletes every stored binary
+	static void Clear();
+
+	static uint64_t MakeKey(const std::vector<std::string>& sources, const std::string& defines);
+
+	// Linked program for key, or 0 on a miss or when the driver rejects the binary
+	static unsigned int Load(uint64_t key);
+	// Program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+	static void Store(uint64_t key, unsigned int program);
+	static void AddCompileTime(double ms);
+
+	// Binds every live program and draws nothing through it, so drivers that finish
+	// compiling on first use do it now instead of during the first frames
+	static void WarmUp();
+	static void OnDeleteProgram(unsigned int program);
+
+	inline static const ProgramCacheStats& GetStats() { return s_Stats; }
+	inline static void ResetStats() { s_Stats = {}; }
+
+private:
+	static std::string s_Directory;
+	static std::vector<unsigned int> s_Programs;
+	static ProgramCacheStats s_Stats;
+};
@@ -0,0 +1,254 @@
+#include "RenderQueue.h"
+#include "Renderer.h"
+#include "Texture.h"
+#include "GLStateCache.h"
+#include "StreamBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Key layout (bit 63 first)
+//   opaque:      0 | shader:12 | vao:12 | texture:12 | depth:24 | 0:3
+//   transparent: 1 | ~depth:24 | shader:12 | vao:12 | texture:12 | 0:3
+// GL names are truncated to 12 bits, a collision only costs a redundant bind.
+static const uint64_t ID_MASK = 0xFFF;
+static const uint64_t DEPTH_MASK = 0xFFFFFF;
+
+static constexpr UniformHandle MODEL_UNIFORM("u_Model");
+static constexpr UniformHandle TEXTURE_INDEX_UNIFORM("u_TextureIndex");
+
+static uint64_t QuantizeDepth(float depth)
+{
+	if (!(depth > 0.0f)) { return 0; }
+
+	// positive IEEE floats compare like their bit patterns, keep the top 24 bits
+	uint32_t bits;
+	std::memcpy(&bits, &depth, sizeof(bits));
+	return (bits >> 7) & DEPTH_MASK;
+}
+
+RenderQueue::RenderQueue()
+	: m_Stats({ 0, 0, 0, 0, 0 }), m_Stream(nullptr), m_CommandOffset(0)
+{
+}
+
+bool RenderQueue::CanMultiDraw(const DrawPacket& first, const DrawPacket& packet)
+{
+	if (packet.multiDrawShader != first.multiDrawShader || packet.vertexArray != first.vertexArray
+		|| packet.indexBuffer != first.indexBuffer)
+	{
+		return false;
+	}
+	for (unsigned int slot = 0; slot < RENDER_QUEUE_MAX_TEXTURES; slot++)
+	{
+		if (packet.textures[slot] != first.textures[slot]) { return false; }
+	}
+	return true;
+}
+
+// Every packet gets its command and record in sorted order, whether or not it ends up in
+// a multi draw, so the record index doubles as the command's baseInstance
+bool RenderQueue::UploadMultiDraw()
+{
+	unsigned int count = (unsigned int)m_Order.size();
+	unsigned int commandBytes = count * sizeof(DrawElementsIndirectCommand);
+	// a full stream buffer draws this frame's queue one packet at a time instead
+	StreamAllocation records = m_Stream->Allocate(count * sizeof(DrawDataRecord), m_Stream->GetStorageAlignment());
+	if (!records.Pointer) { return false; }
+	StreamAllocation commands = m_Stream->Allocate(commandBytes, 4);
+	if (!commands.Pointer) { return false; }
+
+	DrawElementsIndirectCommand* command = (DrawElementsIndirectCommand*)commands.Pointer;
+	DrawDataRecord* record = (DrawDataRecord*)records.Pointer;
+	for (unsigned int i = 0; i < count; i++, command++, record++)
+	{
+		const DrawPacket& packet = m_Packets[m_Order[i]];
+		if (packet.indexBuffer)
+		{
+			*command = { packet.indexBuffer->GetCount(), 1, 0, 0, i };
+		}
+		else
+		{
+			// same stride for both kinds, an arrays command only reads the first four fields
+			DrawArraysIndirectCommand arrays = { packet.vertexCount, 1, 0, i };
+			std::memcpy(command, &arrays, sizeof(arrays));
+		}
+		record->Model = packet.model;
+		record->Material = packet.material;
+	}
+
+	m_CommandOffset = commands.Offset;
+	GLStateCache::Get().BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_Stream->GetRendererID());
+	GLCall(glBindBufferRange(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_BINDING, m_Stream->GetRendererID(),
+		records.Offset, count * sizeof(DrawDataRecord)));
+	GLStateCache::Get().OnBindBufferBase(GL_SHADER_STORAGE_BUFFER, m_Stream->GetRendererID());
+	return true;
+}
+
+uint64_t RenderQueue::MakeSortKey(const DrawPacket& packet)
+{
+	uint64_t shader = packet.shader->GetRendererID() & ID_MASK;
+	uint64_t vao = packet.vertexArray->GetRendererID() & ID_MASK;
+	uint64_t texture = packet.textures[0] ? packet.textures[0]->GetRendererID() & ID_MASK : 0;
+	uint64_t depth = QuantizeDepth(packet.depth);
+
+	if (packet.transparent)
+	{
+		return (1ull << 63) | ((~depth & DEPTH_MASK) << 39) | (shader << 27) | (vao << 15) | (texture << 3);
+	}
+	return (shader << 51) | (vao << 39) | (texture << 27) | (depth << 3);
+}
+
+void RenderQueue::Submit(const DrawPacket& packet)
+{
+	m_Packets.push_back(packet);
+	m_Keys.push_back(MakeSortKey(packet));
+}
+
+// LSD radix sort of (key, packet index) pairs, one byte per pass.
+// Passes where every key has the same byte are skipped, which is most of
+// them since the low bits are mostly padding and IDs repeat a lot.
+void RenderQueue::RadixSort()
+{
+	size_t count = m_Keys.size();
+	m_Order.resize(count);
+	m_KeysScratch.resize(count);
+	m_OrderScratch.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		m_Order[i] = (unsigned int)i;
+	}
+
+	for (unsigned int shift = 0; shift < 64; shift += 8)
+	{
+		size_t histogram[256] = {};
+		for (size_t i = 0; i < count; i++)
+		{
+			histogram[(m_Keys[i] >> shift) & 0xFF]++;
+		}
+		if (histogram[(m_Keys[0] >> shift) & 0xFF] == count) { continue; }
+
+		size_t offset = 0;
+		for (unsigned int b = 0; b < 256; b++)
+		{
+			size_t n = histogram[b];
+			histogram[b] = offset;
+			offset += n;
+		}
+		for (size_t i = 0; i < count; i++)
+		{
+			size_t dst = histogram[(m_Keys[i] >> shift) & 0xFF]++;
+			m_KeysScratch[dst] = m_Keys[i];
+			m_OrderScratch[dst] = m_Order[i];
+		}
+		m_Keys.swap(m_KeysScratch);
+		m_Order.swap(m_OrderScratch);
+	}
+}
+
+void RenderQueue::Flush()
+{
+	m_Stats = { (unsigned int)m_Packets.size(), 0, 0, 0, 0 };
+	if (m_Packets.empty()) { return; }
+
+	RadixSort();
+	bool multiDrawReady = m_Stream && UploadMultiDraw();
+
+	unsigned int naive = 0;
+	Shader* boundShader = nullptr;
+	const VertexArray* boundVertexArray = nullptr;
+	const IndexBuffer* boundIndexBuffer = nullptr;
+	const Texture* boundTextures[RENDER_QUEUE_MAX_TEXTURES] = {};
+
+	for (size_t i = 0; i < m_Order.size();)
+	{
+		DrawPacket& packet = m_Packets[m_Order[i]];
+		size_t end = i + 1;
+		bool multiDraw = multiDrawReady && packet.multiDrawShader;
+		if (multiDraw)
+		{
+			while (end < m_Order.size() && CanMultiDraw(packet, m_Packets[m_Order[end]])) { end++; }
+		}
+		Shader* shader = multiDraw ? packet.multiDrawShader : packet.shader;
+
+		// what binding everything for every packet of the run would have cost
+		unsigned int binds = packet.indexBuffer ? 3 : 2;
+		for (const Texture* texture : packet.textures) { binds += texture ? 1 : 0; }
+		naive += binds * (unsigned int)(end - i);
+
+		if (shader != boundShader)
+		{
+			shader->Bind();
+			boundShader = shader;
+			m_Stats.StateChanges++;
+		}
+		if (packet.vertexArray != boundVertexArray)
+		{
+			packet.vertexArray->Bind();
+			boundVertexArray = packet.vertexArray;
+			// the element buffer binding belongs to the VAO
+			boundIndexBuffer = nullptr;
+			m_Stats.StateChanges++;
+		}
+		for (unsigned int slot = 0; slot < RENDER_QUEUE_MAX_TEXTURES; slot++)
+		{
+			const Texture* texture = packet.textures[slot];
+			if (!texture) { continue; }
+
+			if (texture != boundTextures[slot])
+			{
+				texture->Bind(slot);
+				boundTextures[slot] = texture;
+				m_Stats.StateChanges++;
+			}
+		}
+
+		m_Stats.DrawCalls++;
+		if (multiDraw)
+		{
+			const void* offset = (const void*)(m_CommandOffset + i * sizeof(DrawElementsIndirectCommand));
+			GLsizei drawCount = (GLsizei)(end - i);
+			if (packet.indexBuffer)
+			{
+				if (packet.indexBuffer != boundIndexBuffer)
+				{
+					packet.indexBuffer->Bind();
+					boundIndexBuffer = packet.indexBuffer;
+					m_Stats.StateChanges++;
+				}
+				GLCall(glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, offset, drawCount, sizeof(DrawElementsIndirectCommand)));
+			}
+			else
+			{
+				GLCall(glMultiDrawArraysIndirect(GL_TRIANGLES, offset, drawCount, sizeof(DrawElementsIndirectCommand)));
+			}
+			m_Stats.DrawsCollapsed += drawCount - 1;
+			i = end;
+			continue;
+		}
+
+		packet.shader->SetUniformMat4f(MODEL_UNIFORM, packet.model);
+		// a multi draw packet drawn on its own, its TEXTURE_TABLE shader takes the material as a uniform
+		if (packet.multiDrawShader) { packet.shader->SetUniform1i(TEXTURE_INDEX_UNIFORM, (int)packet.material); }
+
+		if (packet.indexBuffer)
+		{
+			if (packet.indexBuffer != boundIndexBuffer)
+			{
+				packet.indexBuffer->Bind();
+				boundIndexBuffer = packet.indexBuffer;
+				m_Stats.StateChanges++;
+			}
+			GLCall(glDrawElements(GL_TRIANGLES, packet.indexBuffer->GetCount(), GL_UNSIGNED_INT, 0));
+		}
+		else
+		{
+			GLCall(glDrawArrays(GL_TRIANGLES, 0, packet.vertexCount));
+		}
+		i++;
+	}
+	m_Stats.StateChangesSaved = naive - m_Stats.StateChanges;
+
+	m_Packets.clear();
+	m_Keys.clear();
+}
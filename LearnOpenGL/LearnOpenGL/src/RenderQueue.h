@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "UniformBlocks.h"
+
+class Shader;
+class VertexArray;
+class IndexBuffer;
+class Texture;
+class StreamBuffer;
+
+const unsigned int RENDER_QUEUE_MAX_TEXTURES = 4;
+
+struct DrawPacket
+{
+	Shader* shader;
+	const VertexArray* vertexArray;
+	const IndexBuffer* indexBuffer;		// nullptr draws vertexCount non-indexed vertices
+	unsigned int vertexCount;
+	const Texture* textures[RENDER_QUEUE_MAX_TEXTURES];	// bound to slots 0..N, nullptr leaves the slot alone
+	glm::mat4 model;
+	float depth;						// distance from the camera
+	bool transparent;
+	// MULTI_DRAW variant of shader, reading model and material from the DrawData SSBO.
+	// nullptr keeps the packet on separate draws even with multi draw enabled
+	Shader* multiDrawShader;
+	// DrawData material, the TextureTable index with TEXTURE_TABLE. A packet with a multi draw
+	// shader that ends up drawn on its own passes it to shader as u_TextureIndex instead
+	unsigned int material;
+};
+
+// Layout of the GL indirect draw records, glMultiDraw*Indirect reads them from the
+// GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand
+{
+	unsigned int Count;
+	unsigned int InstanceCount;
+	unsigned int FirstIndex;
+	int BaseVertex;
+	unsigned int BaseInstance;
+};
+
+struct DrawArraysIndirectCommand
+{
+	unsigned int Count;
+	unsigned int InstanceCount;
+	unsigned int First;
+	unsigned int BaseInstance;
+};
+
+struct RenderQueueStats
+{
+	unsigned int Packets;
+	unsigned int StateChanges;		// binds actually issued
+	unsigned int StateChangesSaved;	// binds skipped compared to binding everything for every packet
+	unsigned int DrawCalls;			// GL draw calls, a multi draw counts once
+	unsigned int DrawsCollapsed;	// packets that didn't need a draw call of their own
+};
+
+// Collects draw packets for a frame, sorts them by a 64-bit key and replays them
+// with as few program/VAO/texture switches as possible.
+// Opaque packets sort by state then front-to-back, transparent ones strictly back-to-front.
+// With multi draw on, runs of sorted packets sharing a multi draw shader, VAO, index buffer
+// and textures go out as one glMultiDraw*Indirect, their models and materials in an SSBO.
+// Commands and records are written straight into a StreamBuffer.
+class RenderQueue
+{
+private:
+	std::vector<DrawPacket> m_Packets;
+	std::vector<uint64_t> m_Keys, m_KeysScratch;
+	std::vector<unsigned int> m_Order, m_OrderScratch;
+	RenderQueueStats m_Stats;
+	// multi draw is on while this is set
+	StreamBuffer* m_Stream;
+	// offset of this flush's commands in the stream buffer
+	unsigned int m_CommandOffset;
+
+	static uint64_t MakeSortKey(const DrawPacket& packet);
+	static bool CanMultiDraw(const DrawPacket& first, const DrawPacket& packet);
+	void RadixSort();
+	// false when the flush doesn't fit in a stream buffer region
+	bool UploadMultiDraw();
+
+public:
+	RenderQueue();
+
+	// Multi draw through stream, nullptr turns it off. Needs GL 4.3 for the indirect draws
+	// and GLSL 4.60 for gl_BaseInstance
+	inline void SetMultiDraw(StreamBuffer* stream) { m_Stream = stream; }
+	inline bool IsMultiDraw() const { return m_Stream != nullptr; }
+
+	void Submit(const DrawPacket& packet);
+	// Sorts and draws everything submitted since the last flush, u_Model is set per packet
+	// and the camera comes from the Camera block uploaded by Renderer::BeginScene
+	void Flush();
+
+	inline const RenderQueueStats& GetStats() const { return m_Stats; }
+};
@@ -1,4 +1,9 @@
 #include "Renderer.h"
+#include "VertexBufferLayout.h"
+#include "StreamBuffer.h"
+#include "UniformBuffer.h"
+#include "UniformBlocks.h"
+#include <cstring>
 #include <iostream>
 
 void GLClearError()
@@ -17,6 +22,33 @@ bool GLLogCall(const char* function, const char* file, int line)
 	return true;
 }
 
+Renderer::Renderer()
+	: m_StreamBuffer(std::make_unique<StreamBuffer>()),
+	m_InstanceLayout(std::make_unique<VertexBufferLayout>()),
+	m_CameraBuffer(std::make_unique<UniformBuffer>((unsigned int)sizeof(CameraBlock), CAMERA_BLOCK_BINDING))
+{
+	m_InstanceLayout->Push<glm::mat4>(1, 1);
+}
+
+Renderer::~Renderer()
+{
+}
+
+void Renderer::BeginScene(const glm::mat4& view, const glm::mat4& projection, float time)
+{
+	CameraBlock camera = {};
+	camera.View = view;
+	camera.Projection = projection;
+	camera.ViewProjection = projection * view;
+	camera.Time = time;
+	m_CameraBuffer->SetData(&camera, sizeof(camera));
+}
+
+void Renderer::EndFrame()
+{
+	m_StreamBuffer->EndFrame();
+}
+
 void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const
 {
 	shader.Bind();
@@ -25,6 +57,43 @@ void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader&
 	GLCall(glDrawElements(GL_TRIANGLES, ib.GetCount(), GL_UNSIGNED_INT, 0));
 }
 
+unsigned int Renderer::UploadInstances(VertexArray& va, const glm::mat4* models, unsigned int instanceCount)
+{
+	// aligned to a whole matrix so the offset is an instance index
+	StreamAllocation allocation = m_StreamBuffer->Allocate(instanceCount * sizeof(glm::mat4), sizeof(glm::mat4));
+	if (!allocation.Pointer)
+	{
+		if (!m_InstanceBuffer) { m_InstanceBuffer = std::make_unique<VertexBuffer>(instanceCount * (unsigned int)sizeof(glm::mat4)); }
+		m_InstanceBuffer->SetData(models, instanceCount * sizeof(glm::mat4));
+		va.SetInstanceBuffer(*m_InstanceBuffer, *m_InstanceLayout);
+		return 0;
+	}
+	std::memcpy(allocation.Pointer, models, instanceCount * sizeof(glm::mat4));
+	va.SetInstanceBuffer(m_StreamBuffer->GetRendererID(), *m_InstanceLayout);
+	return allocation.Offset / sizeof(glm::mat4);
+}
+
+void Renderer::DrawInstanced(VertexArray& va, const Shader& shader, const glm::mat4* models, unsigned int instanceCount, unsigned int vertexCount)
+{
+	if (instanceCount == 0) { return; }
+
+	unsigned int baseInstance = UploadInstances(va, models, instanceCount);
+	shader.Bind();
+	va.Bind();
+	GLCall(glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, vertexCount, instanceCount, baseInstance));
+}
+
+void Renderer::DrawInstanced(VertexArray& va, const IndexBuffer& ib, const Shader& shader, const glm::mat4* models, unsigned int instanceCount)
+{
+	if (instanceCount == 0) { return; }
+
+	unsigned int baseInstance = UploadInstances(va, models, instanceCount);
+	shader.Bind();
+	va.Bind();
+	ib.Bind();
+	GLCall(glDrawElementsInstancedBaseInstance(GL_TRIANGLES, ib.GetCount(), GL_UNSIGNED_INT, 0, instanceCount, baseInstance));
+}
+
 void Renderer::Clear() const
 {
 	GLCall(glClear(GL_COLOR_BUFFER_BIT));
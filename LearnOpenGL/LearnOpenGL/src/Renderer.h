@@ -1,16 +1,30 @@
 #pragma once
 
+#include <memory>
 #include <glad/glad.h>
 
+#include "GLDebug.h"
+
 #include "Shader.h"
 #include "VertexArray.h"
 #include "IndexBuffer.h"
 
+class UniformBuffer;
+class StreamBuffer;
+
 // macros
 #define ASSERT(x) if (!(x)) __debugbreak();
-#define GLCall(x) GLClearError();\
+#if GL_ERROR_CHECK == GL_ERROR_CHECK_SYNC
+#define GLCall(x) GLSetCallSite(#x, __FILE__, __LINE__);\
+	GLClearError();\
 	x;\
 	ASSERT(GLLogCall(#x, __FILE__, __LINE__))
+#elif GL_ERROR_CHECK == GL_ERROR_CHECK_ASYNC
+#define GLCall(x) GLSetCallSite(#x, __FILE__, __LINE__);\
+	x
+#else
+#define GLCall(x) x
+#endif
 
 // function declarations
 void GLClearError();
@@ -19,7 +33,32 @@ bool GLLogCall(const char* function, const char* file, int line);
 class Renderer
 {
 private:
+	// per-frame data: instance matrices and whatever else asks for GetStreamBuffer
+	std::unique_ptr<StreamBuffer> m_StreamBuffer;
+	// instance batches bigger than a stream buffer region, orphaned on every upload
+	std::unique_ptr<VertexBuffer> m_InstanceBuffer;
+	std::unique_ptr<VertexBufferLayout> m_InstanceLayout;
+	// shared Camera block, see UniformBlocks.h. It stays put for benchmarks that set it
+	// once, a stream buffer region would be reused under it
+	std::unique_ptr<UniformBuffer> m_CameraBuffer;
+
+	// Writes the matrices where the instanced attributes read them, returns the first instance to draw
+	unsigned int UploadInstances(VertexArray& va, const glm::mat4* models, unsigned int instanceCount);
+
 public:
+	Renderer();
+	~Renderer();
+
+	// Uploads the Camera block once, every shader declaring it reads the same data
+	void BeginScene(const glm::mat4& view, const glm::mat4& projection, float time);
+	// After the frame's last draw, lets the stream buffer move on to its next region
+	void EndFrame();
+
 	void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const;
+	// Instanced draws, the shader reads the model matrix from attribute locations after the vertex attributes
+	void DrawInstanced(VertexArray& va, const Shader& shader, const glm::mat4* models, unsigned int instanceCount, unsigned int vertexCount);
+	void DrawInstanced(VertexArray& va, const IndexBuffer& ib, const Shader& shader, const glm::mat4* models, unsigned int instanceCount);
 	void Clear() const;
+
+	inline StreamBuffer& GetStreamBuffer() { return *m_StreamBuffer; }
 };
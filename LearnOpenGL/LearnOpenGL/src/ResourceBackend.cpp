@@ -0,0 +1,23 @@
+#include "ResourceBackend.h"
+
+#include <glad/glad.h>
+
+// picked on first use, the loader has run by then
+static int s_Backend = -1;
+
+ResourceBackend GetResourceBackend()
+{
+	if (s_Backend < 0) { SetResourceBackend(ResourceBackend::DirectStateAccess); }
+	return (ResourceBackend)s_Backend;
+}
+
+void SetResourceBackend(ResourceBackend backend)
+{
+	if (backend == ResourceBackend::DirectStateAccess && !GLAD_GL_VERSION_4_5) { backend = ResourceBackend::BindToEdit; }
+	s_Backend = (int)backend;
+}
+
+const char* GetResourceBackendName(ResourceBackend backend)
+{
+	return backend == ResourceBackend::DirectStateAccess ? "dsa" : "bind";
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+// How Texture, VertexBuffer and IndexBuffer create and fill their GL objects.
+//   DirectStateAccess: glCreate*, immutable glTextureStorage2D/glNamedBufferStorage and the
+//                      named edit calls, nothing gets bound (GL 4.5)
+//   BindToEdit:        glGen* + bind + glTexImage2D/glBufferData, any context
+enum class ResourceBackend { BindToEdit, DirectStateAccess };
+
+// DirectStateAccess when the context is 4.5 or later, unless SetResourceBackend said otherwise
+ResourceBackend GetResourceBackend();
+// Objects keep working whichever backend made them. Asking for DSA on an older context is ignored.
+void SetResourceBackend(ResourceBackend backend);
+const char* GetResourceBackendName(ResourceBackend backend);
+
+inline bool UseDirectStateAccess() { return GetResourceBackend() == ResourceBackend::DirectStateAccess; }
@@ -0,0 +1,149 @@
+#include "ResourceManager.h"
+#include "ShaderLibrary.h"
+#include "Texture.h"
+#include "CpuProfiler.h"
+#include "StatsOverlay.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+
+#include "imgui/imgui.h"
+
+ResourceManager::ResourceManager(ShaderLibrary& shaders, TextureStreamer* streamer)
+	: m_Shaders(shaders), m_Streamer(streamer), m_TextureBudget(RESOURCE_TEXTURE_BUDGET),
+	m_DecodedBudget(RESOURCE_DECODED_BUDGET), m_Stats()
+{
+}
+
+std::string ResourceManager::Canonicalize(const std::string& path)
+{
+	// files that don't exist keep their path, loading them reports the error
+	std::error_code error;
+	std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+	return error ? path : canonical.generic_string();
+}
+
+const ResourceManager::DecodedImage* ResourceManager::Decode(const std::string& path)
+{
+	auto it = m_Decoded.find(path);
+	if (it != m_Decoded.end())
+	{
+		m_DecodedUse.splice(m_DecodedUse.begin(), m_DecodedUse, it->second.Use);
+		m_Stats.DecodeHits++;
+		return &it->second;
+	}
+
+	DecodedImage decoded;
+	if (!LoadImageRGBA(path, decoded.Pixels, decoded.Width, decoded.Height)) { return nullptr; }
+
+	m_DecodedUse.push_front(path);
+	DecodedImage& image = m_Decoded[path];
+	image = std::move(decoded);
+	image.Use = m_DecodedUse.begin();
+	return &image;
+}
+
+std::shared_ptr<Texture> ResourceManager::GetTexture(const std::string& path, const TextureParams& params)
+{
+	std::string canonical = Canonicalize(path);
+	std::string key = params.Mipmaps ? canonical + "|mipmaps" : canonical;
+	auto it = m_Textures.find(key);
+	if (it != m_Textures.end())
+	{
+		m_TextureUse.splice(m_TextureUse.begin(), m_TextureUse, it->second.Use);
+		m_Stats.Hits++;
+		return it->second.Resource;
+	}
+	m_Stats.Misses++;
+
+	TextureEntry entry = { nullptr, {}, false };
+	bool compressed = canonical.size() > 5 && canonical.compare(canonical.size() - 5, 5, ".ktx2") == 0;
+	if (params.Async && m_Streamer && !compressed)
+	{
+		entry.Resource = Texture::LoadAsync(canonical, *m_Streamer);
+		entry.PendingMipmaps = params.Mipmaps;
+	}
+	else if (const DecodedImage* image = compressed ? nullptr : Decode(canonical))
+	{
+		entry.Resource = std::make_shared<Texture>(image->Width, image->Height, image->Pixels.data());
+		if (params.Mipmaps) { entry.Resource->GenerateMipmaps(1 + (int)std::log2(std::max(image->Width, image->Height))); }
+	}
+	else
+	{
+		// cooked files carry their own mips, failed decodes end up as Texture's fallback
+		entry.Resource = std::make_shared<Texture>(canonical);
+	}
+
+	m_TextureUse.push_front(key);
+	entry.Use = m_TextureUse.begin();
+	std::shared_ptr<Texture> texture = entry.Resource;
+	m_Textures[key] = std::move(entry);
+	Trim();
+	return texture;
+}
+
+Shader& ResourceManager::GetShader(const std::string& path, const ShaderDefines& defines)
+{
+	unsigned int variants = m_Shaders.GetVariantCount();
+	Shader& shader = m_Shaders.Get(path, defines);
+	if (m_Shaders.GetVariantCount() > variants) { m_Stats.Misses++; }
+	else { m_Stats.Hits++; }
+	return shader;
+}
+
+void ResourceManager::Update()
+{
+	for (auto& pair : m_Textures)
+	{
+		TextureEntry& entry = pair.second;
+		if (entry.PendingMipmaps && !entry.Resource->IsLoading())
+		{
+			int size = std::max(entry.Resource->GetWidth(), entry.Resource->GetHeight());
+			entry.Resource->GenerateMipmaps(1 + (int)std::log2(size));
+			entry.PendingMipmaps = false;
+		}
+	}
+	Trim();
+}
+
+void ResourceManager::Trim()
+{
+	m_Stats.TextureBytes = 0;
+	for (const auto& pair : m_Textures) { m_Stats.TextureBytes += pair.second.Resource->GetMemorySize(); }
+
+	// oldest first, textures someone still holds stay whatever the budget says
+	for (auto it = m_TextureUse.end(); it != m_TextureUse.begin() && m_Stats.TextureBytes > m_TextureBudget;)
+	{
+		--it;
+		TextureEntry& entry = m_Textures[*it];
+		if (entry.Resource.use_count() > 1) { continue; }
+
+		m_Stats.TextureBytes -= entry.Resource->GetMemorySize();
+		m_Stats.Evictions++;
+		m_Textures.erase(*it);
+		it = m_TextureUse.erase(it);
+	}
+
+	m_Stats.DecodedBytes = 0;
+	for (const auto& pair : m_Decoded) { m_Stats.DecodedBytes += pair.second.Pixels.size(); }
+	while (m_Stats.DecodedBytes > m_DecodedBudget && !m_DecodedUse.empty())
+	{
+		DecodedImage& image = m_Decoded[m_DecodedUse.back()];
+		m_Stats.DecodedBytes -= image.Pixels.size();
+		m_Decoded.erase(m_DecodedUse.back());
+		m_DecodedUse.pop_back();
+	}
+
+	m_Stats.Textures = (unsigned int)m_Textures.size();
+	m_Stats.Decoded = (unsigned int)m_Decoded.size();
+}
+
+void ResourceManager::OnImGuiRender()
+{
+	BeginStatsSection();
+	ImGui::Text("Resources: %u hits, %u misses, %u evicted", m_Stats.Hits, m_Stats.Misses, m_Stats.Evictions);
+	ImGui::Text("%u textures %.1f / %.1f MB, %u decoded %.1f / %.1f MB", m_Stats.Textures, m_Stats.TextureBytes / 1048576.0,
+		m_TextureBudget / 1048576.0, m_Stats.Decoded, m_Stats.DecodedBytes / 1048576.0, m_DecodedBudget / 1048576.0);
+	EndStatsOverlay();
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ShaderPreprocessor.h"
+
+class Shader;
+class ShaderLibrary;
+class Texture;
+class TextureStreamer;
+
+// defaults for SetTextureBudget / SetDecodedBudget
+const size_t RESOURCE_TEXTURE_BUDGET = 256 * 1024 * 1024;
+const size_t RESOURCE_DECODED_BUDGET = 64 * 1024 * 1024;
+
+struct TextureParams
+{
+	bool Mipmaps = false;
+	// through the TextureStreamer when the manager has one, the key ignores it
+	bool Async = false;
+};
+
+struct ResourceStats
+{
+	unsigned int Hits;			// already loaded, handed out again
+	unsigned int Misses;		// loaded or compiled
+	unsigned int DecodeHits;	// textures rebuilt from the decoded cache instead of the file
+	unsigned int Evictions;
+	unsigned int Textures;		// resident, in use or not
+	unsigned int Decoded;
+	size_t TextureBytes;		// GPU texel storage of the resident textures
+	size_t DecodedBytes;		// decoded images kept in RAM
+};
+
+// Hands out shared textures keyed by canonical path and load parameters, so a file is
+// decoded and uploaded once however often it's asked for. Textures nobody holds any more
+// stay resident until the texture budget runs out, then the least recently used go first.
+// Decoded pixels are kept under their own budget, so an evicted texture that comes back
+// skips stb_image. Shaders are deduplicated by the ShaderLibrary, this only counts them.
+class ResourceManager
+{
+private:
+	struct TextureEntry
+	{
+		std::shared_ptr<Texture> Resource;
+		std::list<std::string>::iterator Use;
+		bool PendingMipmaps;	// async load, mips are built once it lands
+	};
+
+	struct DecodedImage
+	{
+		std::vector<unsigned char> Pixels;
+		int Width, Height;
+		std::list<std::string>::iterator Use;
+	};
+
+	ShaderLibrary& m_Shaders;
+	TextureStreamer* m_Streamer;
+	std::unordered_map<std::string, TextureEntry> m_Textures;
+	std::list<std::string> m_TextureUse;	// most recently used first
+	std::unordered_map<std::string, DecodedImage> m_Decoded;
+	std::list<std::string> m_DecodedUse;
+	size_t m_TextureBudget;
+	size_t m_DecodedBudget;
+	ResourceStats m_Stats;
+
+	static std::string Canonicalize(const std::string& path);
+	// Pixels of the file, from the cache or freshly decoded, null when it can't be loaded
+	const DecodedImage* Decode(const std::string& path);
+	void Trim();
+
+public:
+	ResourceManager(ShaderLibrary& shaders, TextureStreamer* streamer = nullptr);
+
+	std::shared_ptr<Texture> GetTexture(const std::string& path, const TextureParams& params = TextureParams());
+	Shader& GetShader(const std::string& path, const ShaderDefines& defines = ShaderDefines());
+
+	inline void SetTextureBudget(size_t bytes) { m_TextureBudget = bytes; Trim(); }
+	inline void SetDecodedBudget(size_t bytes) { m_DecodedBudget = bytes; Trim(); }
+
+	// Finishes async loads that landed and evicts down to the budgets, once per frame
+	void Update();
+
+	inline ShaderLibrary& GetShaders() const { return m_Shaders; }
+	inline const ResourceStats& GetStats() const { return m_Stats; }
+	void OnImGuiRender();
+};
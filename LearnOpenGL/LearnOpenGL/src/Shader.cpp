@@ -4,16 +4,35 @@
 #include <string>
 #include <sstream>
 #include "Renderer.h"
+#include "GLStateCache.h"
+#include "CpuProfiler.h"
+#include "UniformBuffer.h"
+#include "ProgramCache.h"
+#include "VertexBufferLayout.h"
 
-Shader::Shader(const std::string & filepath)
-	: m_Filepath(filepath), m_RendererID(0)
+#include <algorithm>
+#include <chrono>
+
+Shader::Shader(const std::string& filepath, const ShaderDefines& defines)
+	: m_Filepath(filepath), m_Defines(defines), m_RendererID(0)
 {
 	ShaderProgramSource sps = ParseShader(filepath);
-	m_RendererID = CreateShaderProgram(sps.VertexSource, sps.FragmentSource);
+	m_RendererID = CreateShaderProgram(sps);
+	Reflect();
+	BindBlocks();
+}
+
+Shader::Shader(const std::string& filepath, const ShaderDefines& defines, unsigned int program, const std::vector<std::string>& includes)
+	: m_Filepath(filepath), m_Defines(defines), m_Includes(includes), m_RendererID(program)
+{
+	Reflect();
+	BindBlocks();
 }
 
 Shader::~Shader()
 {
+	GLStateCache::Get().OnDeleteProgram(m_RendererID);
+	ProgramCache::OnDeleteProgram(m_RendererID);
 	GLCall(glDeleteProgram(m_RendererID));
 }
 
@@ -39,75 +58,83 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
 	return id;
 }
 
-unsigned int Shader::CreateShaderProgram(const std::string& vertexShader, const std::string& fragmentShader)
+unsigned int Shader::CreateShaderProgram(const ShaderProgramSource& source)
 {
-	GLCall(unsigned int program = glCreateProgram());
-	unsigned int vs = CompileShader(GL_VERTEX_SHADER, vertexShader);
-	unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragmentShader);
+	std::vector<std::pair<unsigned int, const std::string*>> stages = source.GetStages();
+	std::vector<std::string> sources;
+	for (const auto& stage : stages) { sources.push_back(*stage.second); }
+	uint64_t key = ProgramCache::MakeKey(sources, m_Defines.ToString());
+	if (unsigned int cached = ProgramCache::Load(key)) { return cached; }
 
-	GLCall(glAttachShader(program, vs));
-	GLCall(glAttachShader(program, fs));
+	auto start = std::chrono::high_resolution_clock::now();
+	GLCall(unsigned int program = glCreateProgram());
+	std::vector<unsigned int> shaders;
+	for (const auto& stage : stages)
+	{
+		shaders.push_back(CompileShader(stage.first, *stage.second));
+		GLCall(glAttachShader(program, shaders.back()));
+	}
+	GLCall(glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
 	GLCall(glLinkProgram(program));
 
 	// Error handling for linking program (glLinkProgram)
 	int  success;
 	char infoLog[512];
-	glGetProgramiv(program, GL_COMPILE_STATUS, &success);
+	GLCall(glGetProgramiv(program, GL_LINK_STATUS, &success));
 	if (!success)
 	{
-		glGetProgramInfoLog(program, 512, NULL, infoLog);
+		GLCall(glGetProgramInfoLog(program, 512, NULL, infoLog));
 		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
 		GLCall(glDeleteProgram(program));
 		return 0;
 	}
 
 	GLCall(glValidateProgram(program));
-	GLCall(glDeleteShader(vs));
-	GLCall(glDeleteShader(fs));
+	for (unsigned int shader : shaders)
+	{
+		GLCall(glDeleteShader(shader));
+	}
 
+	ProgramCache::AddCompileTime(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+	ProgramCache::Store(key, program);
 	return program;
 }
 
+unsigned int Shader::CreateShaderProgram(const std::string& vertexShader, const std::string& fragmentShader)
+{
+	ShaderProgramSource source;
+	source.VertexSource = vertexShader;
+	source.FragmentSource = fragmentShader;
+	return CreateShaderProgram(source);
+}
+
 ShaderProgramSource Shader::ParseShader(const std::string& filepath)
 {
-	std::ifstream stream(filepath);
-	enum class ShaderType
-	{
-		NONE = -1, VERTEX = 0, FRAGMENT = 1
-	};
-	
-	std::string line;
-	std::stringstream ss[2];
-	ShaderType type = ShaderType::NONE;
-	while (getline(stream, line))
-	{
-		if (line.find("#SHADER") != std::string::npos)
-		{
-			if (line.find("VERTEX") != std::string::npos)
-			{
-				type = ShaderType::VERTEX;
-			}
-			else if (line.find("FRAGMENT") != std::string::npos)
-			{
-				type = ShaderType::FRAGMENT;
-			}
-		}
-		else
-		{
-			ss[(int)type] << line << '\n';
-		}
-	}
-	return { ss[0].str(), ss[1].str() };
+	ShaderProgramSource source = ShaderPreprocessor::Process(filepath, m_Defines);
+	m_Includes = source.Includes;
+	return source;
+}
+
+void Shader::SetProgram(unsigned int program)
+{
+	GLStateCache::Get().OnDeleteProgram(m_RendererID);
+	ProgramCache::OnDeleteProgram(m_RendererID);
+	GLCall(glDeleteProgram(m_RendererID));
+
+	m_RendererID = program;
+	m_MissingUniforms.clear();
+	Reflect();
+	BindBlocks();
 }
 
 void Shader::Bind() const
 {
-	GLCall(glUseProgram(m_RendererID));
+	GLStateCache::Get().UseProgram(m_RendererID);
 }
 
 void Shader::Unbind() const
 {
-	GLCall(glUseProgram(0));
+	GLStateCache::Get().UseProgram(0);
 }
 
 void Shader::SetUniform1i(const std::string& name, int value)
@@ -125,18 +152,260 @@ void Shader::SetUniformMat4f(const std::string& name, const glm::mat4& matrix)
 	GLCall(glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, &matrix[0][0]));
 }
 
-int Shader::GetUniformLocation(const std::string& name)
+void Shader::SetUniform1i(UniformHandle handle, int value)
 {
-	if (m_UniformLocationCache.find(name) != m_UniformLocationCache.end())
+	SetUniform(handle, value);
+}
+
+void Shader::SetUniform4f(UniformHandle handle, float v0, float v1, float v2, float v3)
+{
+	SetUniform(handle, glm::vec4(v0, v1, v2, v3));
+}
+
+void Shader::SetUniformMat4f(UniformHandle handle, const glm::mat4& matrix)
+{
+	SetUniform(handle, matrix);
+}
+
+void Shader::SetUniform(UniformHandle handle, int value)
+{
+	GLCall(glUniform1i(GetUniformLocation(handle, GL_INT), value));
+}
+
+void Shader::SetUniform(UniformHandle handle, float value)
+{
+	GLCall(glUniform1f(GetUniformLocation(handle, GL_FLOAT), value));
+}
+
+void Shader::SetUniform(UniformHandle handle, const glm::vec2& value)
+{
+	GLCall(glUniform2fv(GetUniformLocation(handle, GL_FLOAT_VEC2), 1, &value[0]));
+}
+
+void Shader::SetUniform(UniformHandle handle, const glm::vec3& value)
+{
+	GLCall(glUniform3fv(GetUniformLocation(handle, GL_FLOAT_VEC3), 1, &value[0]));
+}
+
+void Shader::SetUniform(UniformHandle handle, const glm::vec4& value)
+{
+	GLCall(glUniform4fv(GetUniformLocation(handle, GL_FLOAT_VEC4), 1, &value[0]));
+}
+
+void Shader::SetUniform(UniformHandle handle, const glm::mat4& value)
+{
+	GLCall(glUniformMatrix4fv(GetUniformLocation(handle, GL_FLOAT_MAT4), 1, GL_FALSE, &value[0][0]));
+}
+
+bool Shader::IsUniformTypeCompatible(unsigned int uniformType, unsigned int setterType)
+{
+	if (uniformType == setterType) { return true; }
+	if (setterType != GL_INT) { return false; }
+
+	// samplers and bools are set through glUniform1i
+	switch (uniformType)
 	{
-		return m_UniformLocationCache[name];
+		case GL_BOOL:
+		case GL_SAMPLER_2D:
+		case GL_SAMPLER_2D_ARRAY:
+		case GL_SAMPLER_3D:
+		case GL_SAMPLER_CUBE:
+		case GL_SAMPLER_2D_SHADOW:
+			return true;
 	}
-	GLCall(int location = glGetUniformLocation(m_RendererID, name.c_str()));
-	if (location == -1)
+	return false;
+}
+
+// Component count per location and number of locations of a GLSL input type
+static void GetAttributeShape(unsigned int type, int& components, int& locations)
+{
+	locations = 1;
+	switch (type)
 	{
-		std::cout << "Warning: uniform " << name << " does not exist." << std::endl;
+		case GL_FLOAT: case GL_INT: case GL_UNSIGNED_INT: components = 1; break;
+		case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_UNSIGNED_INT_VEC2: components = 2; break;
+		case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_UNSIGNED_INT_VEC3: components = 3; break;
+		case GL_FLOAT_MAT3: components = 3; locations = 3; break;
+		case GL_FLOAT_MAT4: components = 4; locations = 4; break;
+		default: components = 4; break;
 	}
-	m_UniformLocationCache[name] = location;
+}
 
-	return location;
+static bool IsIntegerAttribute(unsigned int type)
+{
+	switch (type)
+	{
+		case GL_INT: case GL_INT_VEC2: case GL_INT_VEC3: case GL_INT_VEC4:
+		case GL_UNSIGNED_INT: case GL_UNSIGNED_INT_VEC2: case GL_UNSIGNED_INT_VEC3: case GL_UNSIGNED_INT_VEC4:
+			return true;
+	}
+	return false;
+}
+
+// Reads name, type, size and location of every active uniform, vertex input and block once,
+// so nothing has to be asked of GL while drawing
+void Shader::Reflect()
+{
+	m_Uniforms.clear();
+	m_Attributes.clear();
+	m_UniformBlocks.clear();
+	m_StorageBlocks.clear();
+	if (m_RendererID == 0) { return; }
+
+	char name[256];
+	int count = 0;
+
+	GLCall(glGetProgramInterfaceiv(m_RendererID, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count));
+	for (int i = 0; i < count; i++)
+	{
+		const GLenum properties[] = { GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION, GL_BLOCK_INDEX };
+		int values[4];
+		GLCall(glGetProgramResourceiv(m_RendererID, GL_UNIFORM, i, 4, properties, 4, nullptr, values));
+		if (values[3] != -1) { continue; } // block members are reflected with their block
+
+		int length = 0;
+		GLCall(glGetProgramResourceName(m_RendererID, GL_UNIFORM, i, sizeof(name), &length, name));
+		// arrays are reported as "name[0]", look them up by their plain name
+		std::string uniform(name, length);
+		size_t bracket = uniform.find('[');
+		if (bracket != std::string::npos) { uniform.resize(bracket); }
+
+		m_Uniforms.push_back({ uniform, HashUniformName(uniform.c_str()), values[2], (unsigned int)values[0], values[1] });
+	}
+	std::sort(m_Uniforms.begin(), m_Uniforms.end(),
+		[](const ShaderUniform& a, const ShaderUniform& b) { return a.Hash < b.Hash; });
+	// FindUniform looks names up by hash alone, two names that collide would shadow each other
+	for (size_t i = 1; i < m_Uniforms.size(); i++)
+	{
+		if (m_Uniforms[i].Hash == m_Uniforms[i - 1].Hash)
+		{
+			std::cout << "[Shader] " << m_Filepath << ": uniforms " << m_Uniforms[i - 1].Name << " and "
+				<< m_Uniforms[i].Name << " have the same name hash, rename one of them" << std::endl;
+			ASSERT(false);
+		}
+	}
+
+	GLCall(glGetProgramInterfaceiv(m_RendererID, GL_PROGRAM_INPUT, GL_ACTIVE_RESOURCES, &count));
+	for (int i = 0; i < count; i++)
+	{
+		const GLenum properties[] = { GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION };
+		int values[3];
+		GLCall(glGetProgramResourceiv(m_RendererID, GL_PROGRAM_INPUT, i, 3, properties, 3, nullptr, values));
+		if (values[2] == -1) { continue; } // gl_VertexID and friends
+
+		int length = 0;
+		GLCall(glGetProgramResourceName(m_RendererID, GL_PROGRAM_INPUT, i, sizeof(name), &length, name));
+		m_Attributes.push_back({ std::string(name, length), values[2], (unsigned int)values[0], values[1] });
+	}
+	std::sort(m_Attributes.begin(), m_Attributes.end(),
+		[](const ShaderAttribute& a, const ShaderAttribute& b) { return a.Location < b.Location; });
+
+	const GLenum blockInterfaces[] = { GL_UNIFORM_BLOCK, GL_SHADER_STORAGE_BLOCK };
+	std::vector<ShaderBlock>* blockTables[] = { &m_UniformBlocks, &m_StorageBlocks };
+	for (int table = 0; table < 2; table++)
+	{
+		GLCall(glGetProgramInterfaceiv(m_RendererID, blockInterfaces[table], GL_ACTIVE_RESOURCES, &count));
+		for (int i = 0; i < count; i++)
+		{
+			const GLenum properties[] = { GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+			int values[2];
+			GLCall(glGetProgramResourceiv(m_RendererID, blockInterfaces[table], i, 2, properties, 2, nullptr, values));
+
+			int length = 0;
+			GLCall(glGetProgramResourceName(m_RendererID, blockInterfaces[table], i, sizeof(name), &length, name));
+			blockTables[table]->push_back({ std::string(name, length), (unsigned int)i, values[0], values[1] });
+		}
+	}
+}
+
+void Shader::BindBlocks()
+{
+	// point every named block at its shared binding so one buffer feeds all programs
+	for (ShaderBlock& block : m_UniformBlocks)
+	{
+		int binding = UniformBuffer::GetBlockBinding(block.Name);
+		if (binding == -1)
+		{
+			std::cout << "[Shader] " << m_Filepath << ": no binding registered for uniform block " << block.Name << std::endl;
+			continue;
+		}
+		GLCall(glUniformBlockBinding(m_RendererID, block.Index, binding));
+		block.Binding = binding;
+	}
+	for (ShaderBlock& block : m_StorageBlocks)
+	{
+		// storage blocks without a registered name keep their layout(binding = N)
+		int binding = UniformBuffer::GetBlockBinding(block.Name);
+		if (binding == -1) { continue; }
+		GLCall(glShaderStorageBlockBinding(m_RendererID, block.Index, binding));
+		block.Binding = binding;
+	}
+}
+
+bool Shader::ValidateLayout(const VertexBufferLayout& layout, unsigned int firstLocation) const
+{
+	bool valid = true;
+	const std::vector<VertexBufferElement>& elements = layout.GetElements();
+	for (unsigned int i = 0; i < elements.size(); i++)
+	{
+		int location = (int)(firstLocation + i);
+		const VertexBufferElement& element = elements[i];
+
+		for (const ShaderAttribute& attribute : m_Attributes)
+		{
+			int components, locations;
+			GetAttributeShape(attribute.Type, components, locations);
+			if (location < attribute.Location || location >= attribute.Location + locations * attribute.Size) { continue; }
+
+			if ((int)element.count != components)
+			{
+				std::cout << "[Shader] " << m_Filepath << ": " << attribute.Name << " at location " << location
+					<< " reads " << components << " components, the layout provides " << element.count << std::endl;
+				valid = false;
+			}
+			// integer inputs need glVertexAttribIPointer, VertexArray always converts to float
+			if (IsIntegerAttribute(attribute.Type))
+			{
+				std::cout << "[Shader] " << m_Filepath << ": " << attribute.Name << " is an integer input, the layout feeds it floats" << std::endl;
+				valid = false;
+			}
+		}
+	}
+	return valid;
+}
+
+const ShaderUniform* Shader::FindUniform(UniformHandle handle) const
+{
+	auto it = std::lower_bound(m_Uniforms.begin(), m_Uniforms.end(), handle.Hash,
+		[](const ShaderUniform& uniform, uint32_t hash) { return uniform.Hash < hash; });
+	return (it != m_Uniforms.end() && it->Hash == handle.Hash) ? &*it : nullptr;
+}
+
+int Shader::GetUniformLocation(UniformHandle handle, unsigned int type) const
+{
+	const ShaderUniform* uniform = FindUniform(handle);
+	// -1 makes glUniform* a silent no-op, just like a missing name
+	if (!uniform) { return -1; }
+#ifdef _DEBUG
+	if (!IsUniformTypeCompatible(uniform->Type, type))
+	{
+		std::cout << "[Shader] " << m_Filepath << ": wrong setter type for uniform " << uniform->Name << std::endl;
+		return -1;
+	}
+#endif
+	return uniform->Location;
+}
+
+int Shader::GetUniformLocation(const std::string& name)
+{
+	PROFILE_FUNCTION();
+	UniformHandle handle(name.c_str());
+	if (const ShaderUniform* uniform = FindUniform(handle)) { return uniform->Location; }
+
+	if (std::find(m_MissingUniforms.begin(), m_MissingUniforms.end(), handle.Hash) == m_MissingUniforms.end())
+	{
+		std::cout << "Warning: uniform " << name << " does not exist." << std::endl;
+		m_MissingUniforms.push_back(handle.Hash);
+	}
+	return -1;
 }
@@ -1,36 +1,126 @@
 #pragma once
+#include <cstdint>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
 #include "glm/glm.hpp"
+#include "ShaderPreprocessor.h"
 
-struct ShaderProgramSource
+// FNV-1a hash of a uniform name, usable at compile time
+constexpr uint32_t HashUniformName(const char* name, uint32_t hash = 2166136261u)
 {
-	std::string VertexSource;
-	std::string FragmentSource;
+	return *name ? HashUniformName(name + 1, (hash ^ (uint8_t)*name) * 16777619u) : hash;
+}
+
+// Names a uniform without any strings at runtime, declare them constexpr:
+//   static constexpr UniformHandle MODEL_UNIFORM("u_Model");
+struct UniformHandle
+{
+	uint32_t Hash;
+
+	explicit constexpr UniformHandle(const char* name)
+		: Hash(HashUniformName(name)) {}
+};
+
+class VertexBufferLayout;
+
+// Link-time reflection, rebuilt after every (re)link
+struct ShaderUniform
+{
+	std::string Name;	// arrays without the "[0]"
+	uint32_t Hash;
+	int Location;
+	unsigned int Type;	// GL_FLOAT_VEC3, GL_SAMPLER_2D, ...
+	int Size;			// array length, 1 otherwise
+};
+
+struct ShaderAttribute
+{
+	std::string Name;
+	int Location;
+	unsigned int Type;
+	int Size;
+};
+
+// uniform blocks and shader storage blocks
+struct ShaderBlock
+{
+	std::string Name;
+	unsigned int Index;
+	int Binding;
+	int Size;			// minimum buffer size in bytes
 };
 
 class Shader
 {
 private:
+
 	std::string m_Filepath;
+	ShaderDefines m_Defines;
+	std::vector<std::string> m_Includes;
 	unsigned int m_RendererID;
-	std::unordered_map<std::string, int> m_UniformLocationCache;
+	// every active uniform outside a block, sorted by name hash
+	std::vector<ShaderUniform> m_Uniforms;
+	// vertex inputs, sorted by location
+	std::vector<ShaderAttribute> m_Attributes;
+	std::vector<ShaderBlock> m_UniformBlocks;
+	std::vector<ShaderBlock> m_StorageBlocks;
+	// names already reported missing by the string setters
+	std::vector<uint32_t> m_MissingUniforms;
 
 	unsigned int CompileShader(unsigned int type, const std::string& source);
 	int GetUniformLocation(const std::string& name);
-	ShaderProgramSource ParseShader(const std::string& filepath);
+	int GetUniformLocation(UniformHandle handle, unsigned int type) const;
+	void Reflect();
+	void BindBlocks();
 
 public:
-	Shader(const std::string& filepath);
+	Shader(const std::string& filepath, const ShaderDefines& defines = ShaderDefines());
+	// Takes over a program linked elsewhere (ShaderCompiler), includes as returned by the preprocessor
+	Shader(const std::string& filepath, const ShaderDefines& defines, unsigned int program, const std::vector<std::string>& includes);
 	~Shader();
 
 	void Bind() const;
 	void Unbind() const;
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline const std::string& GetFilepath() const { return m_Filepath; }
+	inline const ShaderDefines& GetDefines() const { return m_Defines; }
+	// Files pulled in through #include by the last ParseShader
+	inline const std::vector<std::string>& GetIncludes() const { return m_Includes; }
+	ShaderProgramSource ParseShader(const std::string& filepath);
+	// Takes over a linked program (hot reload), the old one is deleted. Uniform lookups and
+	// block bindings are rebuilt, uniform values start from their defaults again.
+	void SetProgram(unsigned int program);
+	unsigned int CreateShaderProgram(const ShaderProgramSource& source);
 	unsigned int CreateShaderProgram(const std::string& vertexShader, const std::string& fragmentShader);
 
-	// Set uniforms
+	const ShaderUniform* FindUniform(UniformHandle handle) const;
+	inline const std::vector<ShaderUniform>& GetUniforms() const { return m_Uniforms; }
+	inline const std::vector<ShaderAttribute>& GetAttributes() const { return m_Attributes; }
+	inline const std::vector<ShaderBlock>& GetUniformBlocks() const { return m_UniformBlocks; }
+	inline const std::vector<ShaderBlock>& GetStorageBlocks() const { return m_StorageBlocks; }
+
+	// Checks a layout's attributes (starting at firstLocation) against the shader inputs,
+	// prints every mismatch in component count or integer/float type
+	bool ValidateLayout(const VertexBufferLayout& layout, unsigned int firstLocation = 0) const;
+
+	// Set uniforms, the string versions are the slow path for one-off setup
 	void SetUniform4f(const std::string& name, float v0, float v1, float v2, float v3);
 	void SetUniform1i(const std::string& name, int value);
 	void SetUniformMat4f(const std::string& name, const glm::mat4& matrix);
+
+	void SetUniform4f(UniformHandle handle, float v0, float v1, float v2, float v3);
+	void SetUniform1i(UniformHandle handle, int value);
+	void SetUniformMat4f(UniformHandle handle, const glm::mat4& matrix);
+
+	// Typed setters, debug builds check the value type against the reflected uniform
+	void SetUniform(UniformHandle handle, int value);
+	void SetUniform(UniformHandle handle, float value);
+	void SetUniform(UniformHandle handle, const glm::vec2& value);
+	void SetUniform(UniformHandle handle, const glm::vec3& value);
+	void SetUniform(UniformHandle handle, const glm::vec4& value);
+	void SetUniform(UniformHandle handle, const glm::mat4& value);
+
+	// Whether a setter for setterType (GL_INT, GL_FLOAT_VEC3, ...) can write a uniform of uniformType
+	static bool IsUniformTypeCompatible(unsigned int uniformType, unsigned int setterType);
 };
@@ -0,0 +1,245 @@
+#include "ShaderCompiler.h"
+#include "Renderer.h"
+#include "ProgramCache.h"
+#include "CpuProfiler.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <iostream>
+
+// KHR_parallel_shader_compile isn't in the glad loader, fetched by hand
+static const GLenum COMPLETION_STATUS_KHR = 0x91B1;
+typedef void (APIENTRYP MaxShaderCompilerThreadsProc)(GLuint count);
+
+// more contexts than this mostly add driver memory, compilers share locks internally
+static const unsigned int MAX_COMPILER_WORKERS = 4;
+
+ShaderCompiler::ShaderCompiler(Mode preferred)
+	: m_Mode(MODE_SERIAL), m_Stop(false)
+{
+	if (preferred == MODE_PARALLEL_EXTENSION)
+	{
+		MaxShaderCompilerThreadsProc maxCompilerThreads = nullptr;
+		if (glfwExtensionSupported("GL_KHR_parallel_shader_compile"))
+		{
+			maxCompilerThreads = (MaxShaderCompilerThreadsProc)glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+		}
+		else if (glfwExtensionSupported("GL_ARB_parallel_shader_compile"))
+		{
+			maxCompilerThreads = (MaxShaderCompilerThreadsProc)glfwGetProcAddress("glMaxShaderCompilerThreadsARB");
+		}
+
+		if (maxCompilerThreads)
+		{
+			// let the driver pick how many threads to use
+			GLCall(maxCompilerThreads(0xFFFFFFFF));
+			m_Mode = MODE_PARALLEL_EXTENSION;
+			return;
+		}
+	}
+	if (preferred == MODE_SERIAL) { return; }
+
+	// hidden 1x1 windows sharing objects with the current context, created here because
+	// GLFW only creates windows on the main thread; the workers just make them current
+	GLFWwindow* share = glfwGetCurrentContext();
+	unsigned int workers = std::max(1u, std::min(MAX_COMPILER_WORKERS, std::thread::hardware_concurrency() - 1));
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	for (unsigned int i = 0; i < workers; i++)
+	{
+		GLFWwindow* context = glfwCreateWindow(1, 1, "Shader compiler", nullptr, share);
+		if (!context) { break; }
+		m_Contexts.push_back(context);
+	}
+	glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+
+	if (m_Contexts.empty())
+	{
+		std::cout << "[ShaderCompiler] Can't create shared contexts, compiling serially" << std::endl;
+		return;
+	}
+	m_Mode = MODE_WORKER_THREADS;
+	for (GLFWwindow* context : m_Contexts)
+	{
+		m_Workers.emplace_back(&ShaderCompiler::WorkerMain, this, context);
+	}
+}
+
+ShaderCompiler::~ShaderCompiler()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_QueueMutex);
+		m_Stop = true;
+	}
+	m_QueueWake.notify_all();
+	for (std::thread& worker : m_Workers) { worker.join(); }
+	for (GLFWwindow* context : m_Contexts) { glfwDestroyWindow(context); }
+
+	// nobody will pick these up any more
+	for (std::unique_ptr<Job>& job : m_Jobs)
+	{
+		for (unsigned int shader : job->Shaders) { GLCall(glDeleteShader(shader)); }
+		if (job->Program) { GLCall(glDeleteProgram(job->Program)); }
+	}
+}
+
+const char* ShaderCompiler::GetModeName(Mode mode)
+{
+	switch (mode)
+	{
+		case MODE_PARALLEL_EXTENSION: return "parallel_shader_compile";
+		case MODE_WORKER_THREADS: return "worker contexts";
+		default: return "serial";
+	}
+}
+
+std::shared_future<CompiledProgram> ShaderCompiler::Submit(const std::string& name, const ShaderProgramSource& source, const ShaderDefines& defines)
+{
+	PROFILE_FUNCTION();
+	std::unique_ptr<Job> job = std::make_unique<Job>();
+	job->Name = name;
+	job->Submitted = std::chrono::high_resolution_clock::now();
+	job->Program = 0;
+	job->Done = false;
+
+	std::vector<std::string> sources;
+	for (const auto& stage : source.GetStages())
+	{
+		job->Stages.push_back({ stage.first, *stage.second });
+		sources.push_back(*stage.second);
+	}
+	job->Key = ProgramCache::MakeKey(sources, defines.ToString());
+	std::shared_future<CompiledProgram> future = job->Promise.get_future().share();
+
+	if (unsigned int cached = ProgramCache::Load(job->Key))
+	{
+		job->Promise.set_value({ cached, 0.0, true });
+		return future;
+	}
+
+	switch (m_Mode)
+	{
+		case MODE_WORKER_THREADS:
+		{
+			std::lock_guard<std::mutex> lock(m_QueueMutex);
+			m_Queue.push_back(job.get());
+			m_QueueWake.notify_one();
+			break;
+		}
+		case MODE_PARALLEL_EXTENSION:
+			StartCompile(*job);
+			break;
+		default:
+			StartCompile(*job);
+			Resolve(*job);
+			return future;
+	}
+
+	m_Jobs.push_back(std::move(job));
+	return future;
+}
+
+// Compile and link without any status queries, those would wait for the driver to finish
+void ShaderCompiler::StartCompile(Job& job)
+{
+	GLCall(job.Program = glCreateProgram());
+	for (const auto& stage : job.Stages)
+	{
+		GLCall(unsigned int id = glCreateShader(stage.first));
+		const char* src = stage.second.c_str();
+		GLCall(glShaderSource(id, 1, &src, nullptr));
+		GLCall(glCompileShader(id));
+		GLCall(glAttachShader(job.Program, id));
+		job.Shaders.push_back(id);
+	}
+	GLCall(glProgramParameteri(job.Program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+	GLCall(glLinkProgram(job.Program));
+}
+
+void ShaderCompiler::Resolve(Job& job)
+{
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - job.Submitted).count();
+
+	int success = 0;
+	GLCall(glGetProgramiv(job.Program, GL_LINK_STATUS, &success));
+	if (!success)
+	{
+		char infoLog[512];
+		for (unsigned int id : job.Shaders)
+		{
+			GLCall(glGetShaderInfoLog(id, sizeof(infoLog), NULL, infoLog));
+			if (infoLog[0]) { std::cout << "ERROR::SHADER::COMPILATION_FAILED " << job.Name << "\n" << infoLog << std::endl; }
+		}
+		GLCall(glGetProgramInfoLog(job.Program, sizeof(infoLog), NULL, infoLog));
+		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED " << job.Name << "\n" << infoLog << std::endl;
+		GLCall(glDeleteProgram(job.Program));
+		job.Program = 0;
+	}
+
+	for (unsigned int id : job.Shaders)
+	{
+		if (job.Program) { GLCall(glDetachShader(job.Program, id)); }
+		GLCall(glDeleteShader(id));
+	}
+	job.Shaders.clear();
+
+	if (job.Program)
+	{
+		ProgramCache::AddCompileTime(ms);
+		ProgramCache::Store(job.Key, job.Program);
+	}
+	job.Promise.set_value({ job.Program, ms, false });
+	job.Program = 0;
+}
+
+bool ShaderCompiler::Poll()
+{
+	PROFILE_FUNCTION();
+	m_Jobs.erase(std::remove_if(m_Jobs.begin(), m_Jobs.end(), [&](std::unique_ptr<Job>& job)
+	{
+		if (m_Mode == MODE_WORKER_THREADS)
+		{
+			if (!job->Done.load(std::memory_order_acquire)) { return false; }
+		}
+		else
+		{
+			int complete = 0;
+			GLCall(glGetProgramiv(job->Program, COMPLETION_STATUS_KHR, &complete));
+			if (!complete) { return false; }
+		}
+		Resolve(*job);
+		return true;
+	}), m_Jobs.end());
+	return m_Jobs.empty();
+}
+
+void ShaderCompiler::WaitAll()
+{
+	while (!Poll())
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+void ShaderCompiler::WorkerMain(GLFWwindow* context)
+{
+	glfwMakeContextCurrent(context);
+	while (true)
+	{
+		Job* job = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(m_QueueMutex);
+			m_QueueWake.wait(lock, [&]() { return m_Stop || !m_Queue.empty(); });
+			if (m_Stop) { break; }
+			job = m_Queue.front();
+			m_Queue.pop_front();
+		}
+
+		PROFILE_SCOPE("ShaderCompiler worker compile");
+		StartCompile(*job);
+		// the program only becomes usable from the main context once the link completed here
+		GLCall(glFinish());
+		job->Done.store(true, std::memory_order_release);
+	}
+	glfwMakeContextCurrent(nullptr);
+}
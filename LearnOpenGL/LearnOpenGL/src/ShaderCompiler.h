@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ShaderPreprocessor.h"
+
+struct GLFWwindow;
+
+struct CompiledProgram
+{
+	unsigned int Program;	// 0 when compiling or linking failed
+	double CompileMs;		// submit -> ready
+	bool FromCache;			// loaded by ProgramCache, nothing was compiled
+};
+
+// Batch compiler: Submit starts every compile and link right away and returns a future,
+// Poll (main thread, once per frame) resolves the ones that are ready. Futures are only
+// ever resolved by Poll, so don't block on one without polling (WaitAll does both).
+//   MODE_PARALLEL_EXTENSION  KHR/ARB_parallel_shader_compile, the driver compiles on its threads
+//   MODE_WORKER_THREADS      hidden shared contexts, each with a thread compiling on it
+//   MODE_SERIAL              Submit compiles before returning
+class ShaderCompiler
+{
+public:
+	enum Mode { MODE_SERIAL = 0, MODE_PARALLEL_EXTENSION, MODE_WORKER_THREADS };
+
+private:
+	struct Job
+	{
+		std::string Name;
+		uint64_t Key;
+		std::vector<std::pair<unsigned int, std::string>> Stages;
+		std::promise<CompiledProgram> Promise;
+		std::chrono::high_resolution_clock::time_point Submitted;
+		unsigned int Program;
+		std::vector<unsigned int> Shaders;
+		std::atomic<bool> Done;	// set by the worker thread that compiled it
+	};
+
+	Mode m_Mode;
+	// submitted and not resolved yet, main thread only
+	std::vector<std::unique_ptr<Job>> m_Jobs;
+
+	std::vector<GLFWwindow*> m_Contexts;
+	std::vector<std::thread> m_Workers;
+	std::mutex m_QueueMutex;
+	std::condition_variable m_QueueWake;
+	std::deque<Job*> m_Queue;
+	bool m_Stop;
+
+	static void StartCompile(Job& job);
+	void Resolve(Job& job);
+	void WorkerMain(GLFWwindow* context);
+
+public:
+	// Shares objects with the context current on the calling thread
+	ShaderCompiler(Mode preferred = MODE_PARALLEL_EXTENSION);
+	~ShaderCompiler();
+
+	std::shared_future<CompiledProgram> Submit(const std::string& name, const ShaderProgramSource& source, const ShaderDefines& defines);
+	// Resolves every finished job, true once nothing is pending
+	bool Poll();
+	void WaitAll();
+
+	inline Mode GetMode() const { return m_Mode; }
+	inline unsigned int GetPendingCount() const { return (unsigned int)m_Jobs.size(); }
+	unsigned int GetWorkerCount() const { return (unsigned int)m_Workers.size(); }
+	static const char* GetModeName(Mode mode);
+};
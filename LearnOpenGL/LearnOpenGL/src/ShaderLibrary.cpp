@@ -0,0 +1,231 @@
+#include "ShaderLibrary.h"
+#include "Renderer.h"
+#include "ProgramCache.h"
+#include "CpuProfiler.h"
+#include "StatsOverlay.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+#include "imgui/imgui.h"
+
+static double MillisecondsBetween(std::chrono::high_resolution_clock::time_point start, std::chrono::high_resolution_clock::time_point end)
+{
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static bool IsReady(const std::shared_future<CompiledProgram>& result)
+{
+	return result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+static void DeleteProgram(unsigned int program)
+{
+	if (program == 0) { return; }
+	ProgramCache::OnDeleteProgram(program);
+	GLCall(glDeleteProgram(program));
+}
+
+ShaderLibrary::ShaderLibrary(ShaderCompiler& compiler)
+	: m_Compiler(compiler), m_Stats()
+{
+}
+
+ShaderLibrary::~ShaderLibrary()
+{
+	// the compiler outlives us, jobs still in flight would hand their programs to nobody
+	if (!m_Pending.empty() || !m_Loading.empty()) { m_Compiler.WaitAll(); }
+	// programs the compiler already handed out but nobody took over
+	for (PendingReload& reload : m_Pending)
+	{
+		if (IsReady(reload.result)) { DeleteProgram(reload.result.get().Program); }
+	}
+	for (auto& loading : m_Loading)
+	{
+		if (IsReady(loading.second.Result)) { DeleteProgram(loading.second.Result.get().Program); }
+	}
+}
+
+uint64_t ShaderLibrary::GetVariantKey(const std::string& filepath, const ShaderDefines& defines)
+{
+	// FNV-1a of the canonical path, so every spelling of a file is one variant,
+	// continued from the defines hash
+	std::error_code error;
+	std::string canonical = std::filesystem::weakly_canonical(filepath, error).generic_string();
+	uint64_t key = defines.GetHash();
+	for (unsigned char c : error ? filepath : canonical) { key = (key ^ c) * 1099511628211ull; }
+	return key;
+}
+
+Shader& ShaderLibrary::Get(const std::string& filepath, const ShaderDefines& defines)
+{
+	uint64_t key = GetVariantKey(filepath, defines);
+	auto it = m_Variants.find(key);
+	if (it != m_Variants.end()) { return *it->second; }
+
+	auto loading = m_Loading.find(key);
+	if (loading != m_Loading.end())
+	{
+		// asked for before its preload finished, wait for this one
+		PROFILE_SCOPE("ShaderLibrary::Get wait");
+		while (!IsReady(loading->second.Result))
+		{
+			m_Compiler.Poll();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return AdoptVariant(key);
+	}
+
+	PROFILE_SCOPE("ShaderLibrary::Get compile");
+	std::unique_ptr<Shader>& shader = m_Variants[key];
+	shader = std::make_unique<Shader>(filepath, defines);
+	Add(*shader);
+	return *shader;
+}
+
+void ShaderLibrary::Preload(const std::string& filepath, const ShaderDefines& defines)
+{
+	uint64_t key = GetVariantKey(filepath, defines);
+	if (m_Variants.count(key) || m_Loading.count(key)) { return; }
+
+	ShaderProgramSource source = ShaderPreprocessor::Process(filepath, defines);
+	PendingVariant& variant = m_Loading[key];
+	variant.Filepath = filepath;
+	variant.Defines = defines;
+	variant.Includes = source.Includes;
+	variant.Result = m_Compiler.Submit(filepath, source, defines);
+}
+
+Shader& ShaderLibrary::AdoptVariant(uint64_t key)
+{
+	auto loading = m_Loading.find(key);
+	PendingVariant& variant = loading->second;
+
+	std::unique_ptr<Shader>& shader = m_Variants[key];
+	shader = std::make_unique<Shader>(variant.Filepath, variant.Defines, variant.Result.get().Program, variant.Includes);
+	m_Loading.erase(loading);
+	Add(*shader);
+	return *shader;
+}
+
+void ShaderLibrary::Add(Shader& shader)
+{
+	m_Shaders.push_back(&shader);
+	Watch(shader);
+}
+
+void ShaderLibrary::Watch(const Shader& shader)
+{
+	m_Watcher.Add(shader.GetFilepath());
+	for (const std::string& include : shader.GetIncludes()) { m_Watcher.Add(include); }
+}
+
+void ShaderLibrary::Remove(Shader& shader)
+{
+	// the compile can't be cancelled, its program is deleted once it's done
+	for (PendingReload& reload : m_Pending)
+	{
+		if (reload.shader == &shader) { reload.superseded = true; }
+	}
+	m_Shaders.erase(std::remove(m_Shaders.begin(), m_Shaders.end(), &shader), m_Shaders.end());
+}
+
+void ShaderLibrary::Update()
+{
+	PROFILE_FUNCTION();
+
+	for (const std::string& file : m_Watcher.Poll())
+	{
+		for (Shader* shader : m_Shaders)
+		{
+			// an edited include reloads every shader that pulls it in
+			std::error_code error;
+			const std::vector<std::string>& includes = shader->GetIncludes();
+			if (std::filesystem::equivalent(shader->GetFilepath(), file, error) ||
+				std::find(includes.begin(), includes.end(), file) != includes.end())
+			{
+				BeginReload(*shader);
+			}
+		}
+	}
+
+	m_Compiler.Poll();
+
+	std::vector<uint64_t> loaded;
+	for (auto& loading : m_Loading)
+	{
+		if (IsReady(loading.second.Result)) { loaded.push_back(loading.first); }
+	}
+	for (uint64_t key : loaded) { AdoptVariant(key); }
+
+	m_Pending.erase(std::remove_if(m_Pending.begin(), m_Pending.end(),
+		[&](PendingReload& reload) { return FinishReload(reload); }), m_Pending.end());
+}
+
+void ShaderLibrary::BeginReload(Shader& shader)
+{
+	auto now = std::chrono::high_resolution_clock::now();
+
+	// a newer save replaces a reload that is still compiling
+	for (PendingReload& reload : m_Pending)
+	{
+		if (reload.shader == &shader) { reload.superseded = true; }
+	}
+
+	// includes may have changed too, watch the new set
+	ShaderProgramSource source = shader.ParseShader(shader.GetFilepath());
+	Watch(shader);
+
+	PendingReload reload = {};
+	reload.shader = &shader;
+	reload.result = m_Compiler.Submit(shader.GetFilepath(), source, shader.GetDefines());
+	reload.changed = now;
+	m_Pending.push_back(reload);
+}
+
+bool ShaderLibrary::FinishReload(PendingReload& reload)
+{
+	if (!IsReady(reload.result)) { return false; }
+
+	const CompiledProgram& result = reload.result.get();
+	if (reload.superseded)
+	{
+		DeleteProgram(result.Program);
+		return true;
+	}
+
+	const std::string& filepath = reload.shader->GetFilepath();
+	if (result.Program == 0)
+	{
+		std::cout << "[ShaderLibrary] " << filepath << " failed to build, keeping the old program" << std::endl;
+		m_Stats.Failures++;
+		return true;
+	}
+
+	reload.shader->SetProgram(result.Program);
+
+	m_Stats.Reloads++;
+	m_Stats.LastFile = filepath;
+	m_Stats.LastCompileMs = result.CompileMs;
+	m_Stats.LastLatencyMs = MillisecondsBetween(reload.changed, std::chrono::high_resolution_clock::now());
+	std::cout << "[ShaderLibrary] Reloaded " << filepath << " in " << m_Stats.LastLatencyMs << " ms" << std::endl;
+	return true;
+}
+
+void ShaderLibrary::OnImGuiRender()
+{
+	BeginStatsSection();
+	ImGui::Text("Shader reloads: %u (%u failed), %s", m_Stats.Reloads, m_Stats.Failures,
+		ShaderCompiler::GetModeName(m_Compiler.GetMode()));
+	if (m_Stats.Reloads > 0)
+	{
+		ImGui::Text("%s: latency %.1f ms, compile %.1f ms", m_Stats.LastFile.c_str(), m_Stats.LastLatencyMs, m_Stats.LastCompileMs);
+	}
+	if (!m_Pending.empty())
+	{
+		ImGui::Text("%u compiling...", (unsigned int)m_Pending.size());
+	}
+	EndStatsOverlay();
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "FileWatcher.h"
+#include "Shader.h"
+#include "ShaderCompiler.h"
+
+struct ShaderReloadStats
+{
+	unsigned int Reloads;
+	unsigned int Failures;
+	std::string LastFile;
+	double LastLatencyMs;	// change seen -> new program in use
+	double LastCompileMs;	// compile and link, polled once per frame when the driver compiles in parallel
+};
+
+// Owns shader variants and hot reloads them. Get compiles a (file, defines) permutation
+// the first time it is asked for and hands out the same Shader after that; program
+// binaries are cached on disk by ProgramCache, keyed on the preprocessed source and defines.
+// Preload hands variants to the ShaderCompiler instead, so startup can submit all of
+// them at once and draw a loading frame until IsLoading turns false. The compiler is
+// shared, its worker contexts and threads are made once for every library that uses it.
+// Watched shaders recompile when their file changes, the new program replaces the old
+// one in Update (call it at the start of a frame) and a program that fails to compile
+// or link is thrown away, the old one keeps running.
+class ShaderLibrary
+{
+private:
+	struct PendingVariant
+	{
+		std::string Filepath;
+		ShaderDefines Defines;
+		std::vector<std::string> Includes;
+		std::shared_future<CompiledProgram> Result;
+	};
+
+	struct PendingReload
+	{
+		Shader* shader;
+		std::shared_future<CompiledProgram> result;
+		std::chrono::high_resolution_clock::time_point changed;
+		bool superseded;	// a newer save is compiling, throw this one away
+	};
+
+	std::vector<Shader*> m_Shaders;
+	// variants by hash of path and defines
+	std::unordered_map<uint64_t, std::unique_ptr<Shader>> m_Variants;
+	std::unordered_map<uint64_t, PendingVariant> m_Loading;
+	std::vector<PendingReload> m_Pending;
+	ShaderCompiler& m_Compiler;
+	FileWatcher m_Watcher;
+	ShaderReloadStats m_Stats;
+
+	static uint64_t GetVariantKey(const std::string& filepath, const ShaderDefines& defines);
+	Shader& AdoptVariant(uint64_t key);
+	void Watch(const Shader& shader);
+
+	void BeginReload(Shader& shader);
+	// true once the program is swapped in or thrown away
+	bool FinishReload(PendingReload& reload);
+
+public:
+	ShaderLibrary(ShaderCompiler& compiler);
+	~ShaderLibrary();
+
+	Shader& Get(const std::string& filepath, const ShaderDefines& defines = ShaderDefines());
+	void Preload(const std::string& filepath, const ShaderDefines& defines = ShaderDefines());
+	inline bool IsLoading() const { return !m_Loading.empty(); }
+	// a changed file is compiling, the new program is swapped in by a later Update
+	inline bool IsReloading() const { return !m_Pending.empty(); }
+	inline unsigned int GetLoadingCount() const { return (unsigned int)m_Loading.size(); }
+	inline unsigned int GetVariantCount() const { return (unsigned int)m_Variants.size(); }
+	inline const ShaderCompiler& GetCompiler() const { return m_Compiler; }
+
+	// Watches a shader owned elsewhere, Remove it before destroying it
+	void Add(Shader& shader);
+	void Remove(Shader& shader);
+
+	// Finishes preloads and reloads whose programs are ready and starts reloads for changed files
+	void Update();
+	void OnImGuiRender();
+
+	inline const ShaderReloadStats& GetStats() const { return m_Stats; }
+};
@@ -0,0 +1,214 @@
+#include "ShaderPreprocessor.h"
+#include "CpuProfiler.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+// deep enough for any sane include tree, stops include cycles without a guard
+static const int MAX_INCLUDE_DEPTH = 16;
+
+// FNV-1a, 64 bit
+static uint64_t HashString(const std::string& value, uint64_t hash)
+{
+	for (unsigned char c : value)
+	{
+		hash = (hash ^ c) * 1099511628211ull;
+	}
+	return (hash ^ 0xFF) * 1099511628211ull;
+}
+
+std::vector<std::pair<unsigned int, const std::string*>> ShaderProgramSource::GetStages() const
+{
+	if (!ComputeSource.empty()) { return { { GL_COMPUTE_SHADER, &ComputeSource } }; }
+
+	std::vector<std::pair<unsigned int, const std::string*>> stages;
+	stages.push_back({ GL_VERTEX_SHADER, &VertexSource });
+	if (!GeometrySource.empty()) { stages.push_back({ GL_GEOMETRY_SHADER, &GeometrySource }); }
+	stages.push_back({ GL_FRAGMENT_SHADER, &FragmentSource });
+	return stages;
+}
+
+ShaderDefines::ShaderDefines()
+	: m_Hash(14695981039346656037ull)
+{
+}
+
+ShaderDefines& ShaderDefines::Set(const std::string& name, const std::string& value)
+{
+	auto it = std::lower_bound(m_Defines.begin(), m_Defines.end(), name,
+		[](const std::pair<std::string, std::string>& define, const std::string& name) { return define.first < name; });
+	if (it != m_Defines.end() && it->first == name) { it->second = value; }
+	else { m_Defines.insert(it, { name, value }); }
+
+	m_Hash = 14695981039346656037ull;
+	for (const auto& define : m_Defines)
+	{
+		m_Hash = HashString(define.second, HashString(define.first, m_Hash));
+	}
+	return *this;
+}
+
+std::string ShaderDefines::ToString() const
+{
+	std::string result;
+	for (const auto& define : m_Defines)
+	{
+		result += "#define " + define.first + " " + define.second + "\n";
+	}
+	return result;
+}
+
+static std::string Trim(const std::string& line)
+{
+	size_t start = line.find_first_not_of(" \t\r");
+	size_t end = line.find_last_not_of(" \t\r");
+	return start == std::string::npos ? std::string() : line.substr(start, end - start + 1);
+}
+
+// #ifndef NAME on the first directive and #define NAME on the next one
+static bool HasIncludeGuard(const std::vector<std::string>& lines, std::string& guard)
+{
+	std::vector<std::string> directives;
+	for (const std::string& line : lines)
+	{
+		std::string trimmed = Trim(line);
+		if (trimmed.empty() || trimmed.compare(0, 2, "//") == 0) { continue; }
+		directives.push_back(trimmed);
+		if (directives.size() == 2) { break; }
+	}
+	if (directives.size() < 2 || directives[0].compare(0, 7, "#ifndef") != 0) { return false; }
+
+	guard = Trim(directives[0].substr(7));
+	return directives[1] == "#define " + guard;
+}
+
+// #include "file" is relative to the file containing it
+static std::string ResolveInclude(const std::string& includingFile, const std::string& directive)
+{
+	size_t open = directive.find('"'), close = directive.rfind('"');
+	std::string file = open != close ? directive.substr(open + 1, close - open - 1) : std::string();
+	return (fs::path(includingFile).parent_path() / file).string();
+}
+
+struct StageState
+{
+	std::ostringstream Out;
+	std::vector<std::string> Included;	// files already pasted into this stage with #pragma once
+	std::vector<std::string> Guards;	// include guards already defined in this stage
+};
+
+static bool ReadLines(const std::string& path, std::vector<std::string>& lines)
+{
+	std::ifstream stream(path);
+	if (!stream) { return false; }
+
+	std::string line;
+	while (getline(stream, line)) { lines.push_back(line); }
+	return true;
+}
+
+static void ExpandInclude(const std::string& path, StageState& stage, std::vector<std::string>& includes, int depth)
+{
+	std::string canonical = fs::weakly_canonical(path).string();
+	if (std::find(includes.begin(), includes.end(), canonical) == includes.end()) { includes.push_back(canonical); }
+	if (std::find(stage.Included.begin(), stage.Included.end(), canonical) != stage.Included.end()) { return; }
+
+	std::vector<std::string> lines;
+	if (depth > MAX_INCLUDE_DEPTH || !ReadLines(path, lines))
+	{
+		std::cout << "[ShaderPreprocessor] Can't include " << path << (depth > MAX_INCLUDE_DEPTH ? " (include cycle?)" : "") << std::endl;
+		return;
+	}
+
+	// a guarded file that was pasted already would only add empty lines
+	std::string guard;
+	if (HasIncludeGuard(lines, guard))
+	{
+		if (std::find(stage.Guards.begin(), stage.Guards.end(), guard) != stage.Guards.end()) { return; }
+		stage.Guards.push_back(guard);
+	}
+
+	stage.Out << "#line 1\n";
+	for (size_t i = 0; i < lines.size(); i++)
+	{
+		std::string trimmed = Trim(lines[i]);
+		if (trimmed == "#pragma once")
+		{
+			stage.Included.push_back(canonical);
+			stage.Out << '\n';
+		}
+		else if (trimmed.compare(0, 8, "#include") == 0)
+		{
+			ExpandInclude(ResolveInclude(path, trimmed), stage, includes, depth + 1);
+			stage.Out << "#line " << i + 2 << '\n';
+		}
+		else
+		{
+			stage.Out << lines[i] << '\n';
+		}
+	}
+}
+
+ShaderProgramSource ShaderPreprocessor::Process(const std::string& filepath, const ShaderDefines& defines)
+{
+	PROFILE_FUNCTION();
+	enum class ShaderType
+	{
+		NONE = -1, VERTEX = 0, FRAGMENT = 1, GEOMETRY = 2, COMPUTE = 3
+	};
+
+	ShaderProgramSource source;
+	std::vector<std::string> lines;
+	if (!ReadLines(filepath, lines))
+	{
+		std::cout << "[ShaderPreprocessor] Can't open " << filepath << std::endl;
+		return source;
+	}
+
+	std::string injected = defines.ToString();
+	StageState stages[4];
+	ShaderType type = ShaderType::NONE;
+	for (size_t i = 0; i < lines.size(); i++)
+	{
+		const std::string& line = lines[i];
+		std::string trimmed = Trim(line);
+		if (line.find("#SHADER") != std::string::npos)
+		{
+			if (line.find("VERTEX") != std::string::npos) { type = ShaderType::VERTEX; }
+			else if (line.find("FRAGMENT") != std::string::npos) { type = ShaderType::FRAGMENT; }
+			else if (line.find("GEOMETRY") != std::string::npos) { type = ShaderType::GEOMETRY; }
+			else if (line.find("COMPUTE") != std::string::npos) { type = ShaderType::COMPUTE; }
+			continue;
+		}
+		// anything before the first marker belongs to no stage
+		if (type == ShaderType::NONE) { continue; }
+
+		StageState& stage = stages[(int)type];
+		if (trimmed.compare(0, 8, "#version") == 0)
+		{
+			stage.Out << line << '\n' << injected << "#line " << i + 2 << '\n';
+		}
+		else if (trimmed.compare(0, 8, "#include") == 0)
+		{
+			ExpandInclude(ResolveInclude(filepath, trimmed), stage, source.Includes, 1);
+			stage.Out << "#line " << i + 2 << '\n';
+		}
+		else
+		{
+			stage.Out << line << '\n';
+		}
+	}
+
+	source.VertexSource = stages[0].Out.str();
+	source.FragmentSource = stages[1].Out.str();
+	source.GeometrySource = stages[2].Out.str();
+	source.ComputeSource = stages[3].Out.str();
+	return source;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct ShaderProgramSource
+{
+	std::string VertexSource;
+	std::string FragmentSource;
+	std::string GeometrySource;
+	std::string ComputeSource;
+	// every file pulled in through #include, for hot reload
+	std::vector<std::string> Includes;
+
+	// (GL stage, source) for every stage present, a compute program has nothing else
+	std::vector<std::pair<unsigned int, const std::string*>> GetStages() const;
+};
+
+// Set of #defines selecting a shader permutation, kept sorted so the same set always
+// hashes and prints the same no matter the order it was built in
+class ShaderDefines
+{
+private:
+	std::vector<std::pair<std::string, std::string>> m_Defines;
+	uint64_t m_Hash;
+
+public:
+	ShaderDefines();
+
+	ShaderDefines& Set(const std::string& name, const std::string& value = "1");
+
+	// "#define NAME VALUE" lines, injected right after #version
+	std::string ToString() const;
+	inline uint64_t GetHash() const { return m_Hash; }
+	inline bool IsEmpty() const { return m_Defines.empty(); }
+};
+
+// Splits a .shader file on "#SHADER VERTEX/FRAGMENT/GEOMETRY/COMPUTE" and expands
+// #include "file" (relative to the including file). Included files with "#pragma once"
+// or a regular #ifndef guard are only pasted once per stage. #line directives keep
+// compiler errors pointing at the original line numbers.
+class ShaderPreprocessor
+{
+public:
+	static ShaderProgramSource Process(const std::string& filepath, const ShaderDefines& defines);
+};
@@ -0,0 +1,19 @@
+#include "StatsOverlay.h"
+
+#include "imgui/imgui.h"
+
+void BeginStatsOverlay()
+{
+	ImGui::Begin(STATS_OVERLAY_TITLE);
+}
+
+void BeginStatsSection()
+{
+	ImGui::Begin(STATS_OVERLAY_TITLE);
+	ImGui::Separator();
+}
+
+void EndStatsOverlay()
+{
+	ImGui::End();
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+// The one ImGui window the app's stats go into: the GPU profiler at the top, then a section
+// per subsystem from their OnImGuiRender, in the order Main calls them.
+const char* const STATS_OVERLAY_TITLE = "Stats";
+
+// Opens the window at the top, only the GpuProfiler draws there
+void BeginStatsOverlay();
+// Opens the window again below a separator, for a subsystem's section
+void BeginStatsSection();
+void EndStatsOverlay();
@@ -0,0 +1,116 @@
+#include "StreamBuffer.h"
+#include "Renderer.h"
+#include "GLStateCache.h"
+#include "ResourceBackend.h"
+#include "CpuProfiler.h"
+#include "StatsOverlay.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "imgui/imgui.h"
+
+StreamBuffer::StreamBuffer(unsigned int regionSize)
+	: m_RendererID(0), m_Mapped(nullptr), m_RegionSize(regionSize), m_Region(0), m_Head(0),
+	m_Fences(), m_Stats()
+{
+	GLint uniformAlignment = 256, storageAlignment = 256;
+	GLCall(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment));
+	GLCall(glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment));
+	m_UniformAlignment = (unsigned int)uniformAlignment;
+	m_StorageAlignment = (unsigned int)storageAlignment;
+
+	// regions start on a boundary any binding accepts
+	unsigned int alignment = std::max(m_UniformAlignment, m_StorageAlignment);
+	m_RegionSize = (m_RegionSize + alignment - 1) / alignment * alignment;
+	unsigned int size = m_RegionSize * STREAM_BUFFER_REGIONS;
+
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	if (UseDirectStateAccess())
+	{
+		GLCall(glCreateBuffers(1, &m_RendererID));
+		GLCall(glNamedBufferStorage(m_RendererID, size, nullptr, flags));
+		GLCall(m_Mapped = (unsigned char*)glMapNamedBufferRange(m_RendererID, 0, size, flags));
+	}
+	else
+	{
+		// any target works for creating it, this one is never part of a VAO
+		GLCall(glGenBuffers(1, &m_RendererID));
+		GLStateCache::Get().BindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID);
+		GLCall(glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags));
+		GLCall(m_Mapped = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags));
+	}
+}
+
+StreamBuffer::~StreamBuffer()
+{
+	for (GLsync fence : m_Fences)
+	{
+		if (fence) { GLCall(glDeleteSync(fence)); }
+	}
+	// deleting a buffer unmaps it
+	GLStateCache::Get().OnDeleteBuffer(m_RendererID);
+	GLCall(glDeleteBuffers(1, &m_RendererID));
+}
+
+StreamAllocation StreamBuffer::Allocate(unsigned int size, unsigned int alignment)
+{
+	if (size > m_RegionSize || !m_Mapped) { return { nullptr, 0 }; }
+
+	// aligned from the start of the buffer, so offset / alignment can serve as an element
+	// index (baseVertex, baseInstance) even for sizes that don't divide the region size
+	unsigned int start = (m_Region * m_RegionSize + m_Head + alignment - 1) / alignment * alignment;
+	if (start + size > (m_Region + 1) * m_RegionSize)
+	{
+		// switching regions here would fence it before the draws that read what's already in it
+		m_Stats.Overflows++;
+		return { nullptr, 0 };
+	}
+	m_Head = start + size - m_Region * m_RegionSize;
+	m_Stats.BytesLastFrame = m_Head;
+	return { m_Mapped + start, start };
+}
+
+void StreamBuffer::EndFrame()
+{
+	if (m_Head == 0) { return; }
+
+	GLCall(m_Fences[m_Region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+	m_Stats.PeakBytes = std::max(m_Stats.PeakBytes, m_Head);
+	NextRegion();
+}
+
+void StreamBuffer::NextRegion()
+{
+	m_Region = (m_Region + 1) % STREAM_BUFFER_REGIONS;
+	m_Head = 0;
+	GLsync& fence = m_Fences[m_Region];
+	if (!fence) { return; }
+
+	// usually signalled long ago, otherwise the CPU is STREAM_BUFFER_REGIONS frames ahead
+	GLCall(GLenum status = glClientWaitSync(fence, 0, 0));
+	if (status == GL_TIMEOUT_EXPIRED)
+	{
+		PROFILE_SCOPE("StreamBuffer wait");
+		auto start = std::chrono::high_resolution_clock::now();
+		m_Stats.Waits++;
+		GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		do
+		{
+			GLCall(status = glClientWaitSync(fence, flags, 1000000));
+			flags = 0;
+		} while (status == GL_TIMEOUT_EXPIRED);
+		m_Stats.WaitMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+	GLCall(glDeleteSync(fence));
+	fence = nullptr;
+}
+
+void StreamBuffer::OnImGuiRender()
+{
+	BeginStatsSection();
+	ImGui::Text("Stream buffer: %.1f / %.1f KB a frame, peak %.1f KB", m_Stats.BytesLastFrame / 1024.0,
+		m_RegionSize / 1024.0, m_Stats.PeakBytes / 1024.0);
+	ImGui::Text("%u waits (%.2f ms), %u allocations didn't fit", m_Stats.Waits, m_Stats.WaitMs, m_Stats.Overflows);
+	EndStatsOverlay();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// regions of a StreamBuffer, the CPU writes one while the GPU may still read the others
+const unsigned int STREAM_BUFFER_REGIONS = 3;
+// default region size, what a frame can allocate before Allocate starts failing
+const unsigned int STREAM_BUFFER_REGION_SIZE = 4 * 1024 * 1024;
+
+struct StreamAllocation
+{
+	void* Pointer;			// write here, nullptr when the request doesn't fit in what's left of the region
+	unsigned int Offset;	// the same bytes from the GPU's side, from the start of the buffer
+};
+
+struct StreamBufferStats
+{
+	unsigned int BytesLastFrame;
+	unsigned int PeakBytes;			// the most a frame has allocated
+	unsigned int Waits;				// region switches that had to wait for the GPU
+	unsigned int Overflows;			// allocations that didn't fit in the rest of their region
+	double WaitMs;
+};
+
+// One buffer made with glBufferStorage and mapped once, persistent and coherent, for data
+// that changes every frame. It's split into STREAM_BUFFER_REGIONS regions used round robin:
+// Allocate hands out space in the current region, EndFrame fences it and moves on, waiting
+// only if the GPU hasn't finished the frame that last used the next region. Only EndFrame
+// ever switches regions, so the fence always comes after every draw of the frame. Data is written
+// straight into the mapping and read from it by the GPU, nothing is copied or re-specified.
+// Bind it to whichever target needs it: vertex attributes, GL_DRAW_INDIRECT_BUFFER, or
+// glBindBufferRange for uniform and storage blocks at an offset from Allocate.
+class StreamBuffer
+{
+private:
+	unsigned int m_RendererID;
+	unsigned char* m_Mapped;
+	unsigned int m_RegionSize;
+	unsigned int m_Region;
+	unsigned int m_Head;		// next free byte in the current region
+	GLsync m_Fences[STREAM_BUFFER_REGIONS];
+	unsigned int m_UniformAlignment;
+	unsigned int m_StorageAlignment;
+	StreamBufferStats m_Stats;
+
+	void NextRegion();
+
+public:
+	StreamBuffer(unsigned int regionSize = STREAM_BUFFER_REGION_SIZE);
+	~StreamBuffer();
+
+	// size bytes at an offset that's a multiple of alignment. Null when the rest of the region
+	// is too small, callers fall back to a buffer of their own for the rest of the frame.
+	StreamAllocation Allocate(unsigned int size, unsigned int alignment = 16);
+	// Once per frame after the last draw that reads this frame's allocations
+	void EndFrame();
+
+	// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT and GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, for
+	// allocations bound with glBindBufferRange
+	inline unsigned int GetUniformAlignment() const { return m_UniformAlignment; }
+	inline unsigned int GetStorageAlignment() const { return m_StorageAlignment; }
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline unsigned int GetRegionSize() const { return m_RegionSize; }
+	inline const StreamBufferStats& GetStats() const { return m_Stats; }
+	void OnImGuiRender();
+};
@@ -1,15 +1,183 @@
 #include "Texture.h"
+#include "GLStateCache.h"
+#include "ResourceBackend.h"
+#include "TextureStreamer.h"
+#include "CpuProfiler.h"
+#include "KTX2.h"
 #include "stb_image/stb_image.h"
 
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <iostream>
+
+// EXT_texture_compression_s3tc isn't in the glad loader
+static const GLenum COMPRESSED_RGB_S3TC_DXT1_EXT = 0x83F0;
+static const GLenum COMPRESSED_RGBA_S3TC_DXT5_EXT = 0x83F3;
+
+bool LoadImageRGBA(const std::string& path, std::vector<unsigned char>& pixels, int& width, int& height)
+{
+	PROFILE_FUNCTION();
+	int bpp;
+	unsigned char* data = stbi_load(path.c_str(), &width, &height, &bpp, 4);
+	if (!data) { return false; }
+	pixels.assign(data, data + (size_t)width * height * 4);
+	stbi_image_free(data);
+	return true;
+}
+
 Texture::Texture(const std::string& path)
 	: m_RendererID(0), m_FilePath(path), m_LocalBuffer(nullptr),
-	m_Width(0), m_Height(0), m_BPP(0)
+	m_Width(0), m_Height(0), m_BPP(0), m_MemorySize(0)
+{
+	PROFILE_FUNCTION();
+	if (path.size() > 5 && path.compare(path.size() - 5, 5, ".ktx2") == 0)
+	{
+		if (LoadCompressed(path)) { return; }
+		// a 1x1 black texture keeps draws valid
+		static const unsigned char BLACK[4] = { 0, 0, 0, 255 };
+		m_Width = m_Height = 1;
+		Create(BLACK);
+		return;
+	}
+
+	{
+		PROFILE_SCOPE("stbi_load");
+		m_LocalBuffer = stbi_load(path.c_str(), &m_Width, &m_Height, &m_BPP, 4);
+	}
+
+	Create(m_LocalBuffer);
+
+	if (m_LocalBuffer) { stbi_image_free(m_LocalBuffer); }
+}
+
+Texture::Texture()
+	: m_RendererID(0), m_LocalBuffer(nullptr),
+	m_Width(1), m_Height(1), m_BPP(4), m_MemorySize(4)
 {
-	stbi_set_flip_vertically_on_load(1);
-	m_LocalBuffer = stbi_load(path.c_str(), &m_Width, &m_Height, &m_BPP, 4);
+}
+
+std::unique_ptr<Texture> Texture::LoadAsync(const std::string& path, TextureStreamer& streamer)
+{
+	// mid grey, close to the average of most images
+	static const unsigned char PLACEHOLDER[4] = { 128, 128, 128, 255 };
+
+	std::unique_ptr<Texture> texture(new Texture());
+	texture->m_FilePath = path;
+	texture->Create(PLACEHOLDER);
+
+	texture->m_Request = std::make_shared<TextureRequest>();
+	TextureRequest& request = *texture->m_Request;
+	request.Path = path;
+	request.Target = texture.get();
+	request.Canceled = false;
+	request.Pixels = nullptr;
+	request.Width = 0;
+	request.Height = 0;
+	request.Storage = 0;
+	request.RowsUploaded = 0;
+	streamer.Enqueue(texture->m_Request);
+	return texture;
+}
+
+Texture::Texture(int width, int height, const unsigned char* pixels)
+	: m_RendererID(0), m_LocalBuffer(nullptr),
+	m_Width(width), m_Height(height), m_BPP(4), m_MemorySize(0)
+{
+	Create(pixels);
+}
+
+bool Texture::LoadCompressed(const std::string& path)
+{
+	KTX2Image image;
+	std::string error;
+	{
+		PROFILE_SCOPE("ReadKTX2");
+		if (!ReadKTX2(path, image, error))
+		{
+			std::cout << "[Texture] " << path << ": " << error << "\n";
+			return false;
+		}
+	}
+
+	GLenum format = GL_COMPRESSED_RGBA_BPTC_UNORM;
+	if (image.Format != BlockFormat::BC7)
+	{
+		if (!glfwExtensionSupported("GL_EXT_texture_compression_s3tc"))
+		{
+			std::cout << "[Texture] " << path << ": the driver has no S3TC (BC1/BC3) support\n";
+			return false;
+		}
+		format = image.Format == BlockFormat::BC1 ? COMPRESSED_RGB_S3TC_DXT1_EXT : COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	}
+
+	m_Width = image.Width;
+	m_Height = image.Height;
+	m_BPP = 0;
+	int levels = (int)image.Levels.size();
+	if (UseDirectStateAccess())
+	{
+		GLCall(glCreateTextures(GL_TEXTURE_2D, 1, &m_RendererID));
+		GLCall(glTextureParameteri(m_RendererID, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR));
+		GLCall(glTextureParameteri(m_RendererID, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+		GLCall(glTextureParameteri(m_RendererID, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+		GLCall(glTextureParameteri(m_RendererID, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+		// immutable storage is complete at its last level without MAX_LEVEL
+		GLCall(glTextureStorage2D(m_RendererID, levels, format, m_Width, m_Height));
+		for (int level = 0; level < levels; level++)
+		{
+			const std::vector<unsigned char>& data = image.Levels[level];
+			GLCall(glCompressedTextureSubImage2D(m_RendererID, level, 0, 0, std::max(1, m_Width >> level), std::max(1, m_Height >> level),
+				format, (GLsizei)data.size(), data.data()));
+			m_MemorySize += (unsigned int)data.size();
+		}
+		return true;
+	}
 
 	GLCall(glGenTextures(1, &m_RendererID));
-	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+	GLStateCache::Get().BindTexture(GL_TEXTURE_2D, m_RendererID);
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	// a partial chain is complete at its last level
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1));
+
+	for (int level = 0; level < levels; level++)
+	{
+		const std::vector<unsigned char>& data = image.Levels[level];
+		GLCall(glCompressedTexImage2D(GL_TEXTURE_2D, level, format, std::max(1, m_Width >> level), std::max(1, m_Height >> level),
+			0, (GLsizei)data.size(), data.data()));
+		m_MemorySize += (unsigned int)data.size();
+	}
+
+	GLStateCache::Get().BindTexture(GL_TEXTURE_2D, 0);
+	return true;
+}
+
+void Texture::Create(const unsigned char* pixels)
+{
+	m_RendererID = CreateStorage(m_Width, m_Height, pixels);
+	m_MemorySize = m_Width * m_Height * 4;
+}
+
+unsigned int Texture::CreateStorage(int width, int height, const unsigned char* pixels)
+{
+	unsigned int id;
+	if (UseDirectStateAccess())
+	{
+		GLCall(glCreateTextures(GL_TEXTURE_2D, 1, &id));
+		GLCall(glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+		GLCall(glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+		GLCall(glTextureParameteri(id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+		GLCall(glTextureParameteri(id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+		GLCall(glTextureStorage2D(id, 1, GL_RGBA8, width, height));
+		if (pixels) { GLCall(glTextureSubImage2D(id, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels)); }
+		return id;
+	}
+
+	GLCall(glGenTextures(1, &id));
+	GLStateCache::Get().BindTexture(GL_TEXTURE_2D, id);
 
 	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
 	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
@@ -20,31 +188,81 @@ Texture::Texture(const std::string& path)
 		GL_TEXTURE_2D,
 		0,
 		GL_RGBA8,
-		m_Width,
-		m_Height,
+		width,
+		height,
 		0,
 		GL_RGBA,
 		GL_UNSIGNED_BYTE,
-		m_LocalBuffer
+		pixels
 	));
 
-	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
-
-	if (m_LocalBuffer) { stbi_image_free(m_LocalBuffer); }
+	GLStateCache::Get().BindTexture(GL_TEXTURE_2D, 0);
+	return id;
 }
 
 Texture::~Texture()
 {
+	if (m_Request)
+	{
+		// the streamer frees whatever it has for us on its next Update
+		m_Request->Canceled = true;
+		m_Request->Target = nullptr;
+	}
+	GLStateCache::Get().OnDeleteTexture(m_RendererID);
+	GLCall(glDeleteTextures(1, &m_RendererID));
+}
+
+void Texture::GenerateMipmaps(int levels)
+{
+	// only DSA makes immutable textures, so there's a 4.5 context whenever one needs to grow
+	GLint storageLevels = 0;
+	if (GLAD_GL_VERSION_4_5) { GLCall(glGetTextureParameteriv(m_RendererID, GL_TEXTURE_IMMUTABLE_LEVELS, &storageLevels)); }
+	if (storageLevels != 0 && storageLevels < levels) { Reallocate(levels); }
+
+	if (UseDirectStateAccess())
+	{
+		GLCall(glTextureParameteri(m_RendererID, GL_TEXTURE_MAX_LEVEL, levels - 1));
+		GLCall(glTextureParameteri(m_RendererID, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR));
+		GLCall(glGenerateTextureMipmap(m_RendererID));
+	}
+	else
+	{
+		GLStateCache::Get().BindTexture(GL_TEXTURE_2D, m_RendererID);
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1));
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR));
+		GLCall(glGenerateMipmap(GL_TEXTURE_2D));
+		GLStateCache::Get().BindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	m_MemorySize = 0;
+	for (int level = 0; level < levels; level++)
+	{
+		m_MemorySize += std::max(1, m_Width >> level) * std::max(1, m_Height >> level) * 4;
+	}
+}
+
+void Texture::Reallocate(int levels)
+{
+	unsigned int id;
+	GLCall(glCreateTextures(GL_TEXTURE_2D, 1, &id));
+	GLCall(glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTextureParameteri(id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GLCall(glTextureParameteri(id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	GLCall(glTextureStorage2D(id, levels, GL_RGBA8, m_Width, m_Height));
+	GLCall(glCopyImageSubData(m_RendererID, GL_TEXTURE_2D, 0, 0, 0, 0, id, GL_TEXTURE_2D, 0, 0, 0, 0, m_Width, m_Height, 1));
+
+	GLStateCache::Get().OnDeleteTexture(m_RendererID);
 	GLCall(glDeleteTextures(1, &m_RendererID));
+	m_RendererID = id;
 }
 
 void Texture::Bind(unsigned int slot) const
 {
-	GLCall(glActiveTexture(GL_TEXTURE0 + slot));
-	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+	GLStateCache::Get().ActiveTexture(slot);
+	GLStateCache::Get().BindTexture(GL_TEXTURE_2D, m_RendererID);
 }
 
 void Texture::Unbind() const
 {
-	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	GLStateCache::Get().BindTexture(GL_TEXTURE_2D, 0);
 }
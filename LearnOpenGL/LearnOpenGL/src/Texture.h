@@ -1,7 +1,17 @@
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "Renderer.h"
 
+class TextureStreamer;
+struct TextureRequest;
+
+// Decodes an image file to tightly packed RGBA8 through stb_image, bottom row first like GL
+// wants it. False when the file can't be read or decoded.
+bool LoadImageRGBA(const std::string& path, std::vector<unsigned char>& pixels, int& width, int& height);
+
 class Texture
 {
 private:
@@ -9,14 +19,43 @@ private:
 	std::string m_FilePath;
 	unsigned char* m_LocalBuffer;
 	int m_Width, m_Height, m_BPP;
+	unsigned int m_MemorySize;	// bytes of texel storage, every level
+	// set while LoadAsync is streaming the file in
+	std::shared_ptr<TextureRequest> m_Request;
+
+	Texture();
+	void Create(const unsigned char* pixels);
+	// Block compressed levels straight from a cooked KTX2 file
+	bool LoadCompressed(const std::string& path);
+	// RGBA8 texture object with linear filtering, pixels may be null. Immutable with a single
+	// level under the DSA backend, see ResourceBackend.h
+	static unsigned int CreateStorage(int width, int height, const unsigned char* pixels);
+	// Moves level 0 of an immutable RGBA8 texture to new storage with room for levels
+	void Reallocate(int levels);
+
+	friend class TextureStreamer;
 
 public:
+	// .ktx2 files from the cooker upload as they are, anything else goes through stb_image
 	Texture(const std::string& path);
+	// RGBA8 texture from memory
+	Texture(int width, int height, const unsigned char* pixels);
 	~Texture();
 
+	// Returns right away with a 1x1 placeholder in place of the image, the streamer
+	// swaps the decoded file in over the next frames. Keeps the placeholder on failure.
+	static std::unique_ptr<Texture> LoadAsync(const std::string& path, TextureStreamer& streamer);
+
+	// Builds levels 1..levels-1 from level 0 and samples trilinearly. Immutable textures
+	// without room for them switch to a new GL object, take the renderer ID after this
+	void GenerateMipmaps(int levels);
+
 	void Bind(unsigned int slot = 0) const;
 	void Unbind() const;
 
 	inline int GetWidth() const { return m_Width;  }
 	inline int GetHeight() const { return m_Height;  }
+	inline unsigned int GetMemorySize() const { return m_MemorySize; }
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline bool IsLoading() const { return m_Request != nullptr; }
 };
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include "TextureArray.h"
+#include "Renderer.h"
+#include "GLStateCache.h"
+#include "Texture.h"
+
+#include <iostream>
+
+TextureArray::TextureArray(int width, int height, unsigned int capacity)
+	: m_RendererID(0), m_Width(width), m_Height(height), m_Capacity(capacity), m_LayerCount(0)
+{
+	GLCall(glGenTextures(1, &m_RendererID));
+	GLStateCache::Get().BindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID);
+
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	GLCall(glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA8, m_Width, m_Height, m_Capacity));
+
+	GLStateCache::Get().BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+TextureArray::~TextureArray()
+{
+	GLStateCache::Get().OnDeleteTexture(m_RendererID);
+	GLCall(glDeleteTextures(1, &m_RendererID));
+}
+
+int TextureArray::Add(const unsigned char* pixels)
+{
+	if (m_LayerCount == m_Capacity)
+	{
+		std::cout << "[TextureArray] Full, all " << m_Capacity << " layers are used\n";
+		return -1;
+	}
+
+	GLStateCache::Get().BindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID);
+	GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, m_LayerCount, m_Width, m_Height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+	GLStateCache::Get().BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	return (int)m_LayerCount++;
+}
+
+int TextureArray::Add(const std::string& path)
+{
+	std::vector<unsigned char> pixels;
+	int width, height;
+	if (!LoadImageRGBA(path, pixels, width, height) || width != m_Width || height != m_Height)
+	{
+		std::cout << "[TextureArray] " << path << " doesn't load as " << m_Width << "x" << m_Height << "\n";
+		return -1;
+	}
+	return Add(pixels.data());
+}
+
+void TextureArray::Bind(unsigned int slot) const
+{
+	GLStateCache::Get().ActiveTexture(slot);
+	GLStateCache::Get().BindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+
+// Pool of same-sized RGBA8 textures in one GL_TEXTURE_2D_ARRAY. Shaders pick a texture by
+// layer, so draws with different textures don't have to rebind anything in between.
+class TextureArray
+{
+private:
+	unsigned int m_RendererID;
+	int m_Width, m_Height;
+	unsigned int m_Capacity;
+	unsigned int m_LayerCount;
+
+public:
+	// storage for every layer is allocated up front
+	TextureArray(int width, int height, unsigned int capacity);
+	~TextureArray();
+
+	// Layer of the new texture, -1 when the pool is full or the size doesn't match
+	int Add(const unsigned char* pixels);
+	int Add(const std::string& path);
+
+	void Bind(unsigned int slot = 0) const;
+
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+	inline unsigned int GetLayerCount() const { return m_LayerCount; }
+	inline unsigned int GetCapacity() const { return m_Capacity; }
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+};
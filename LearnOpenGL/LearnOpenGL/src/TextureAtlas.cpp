@@ -0,0 +1,110 @@
+#include "TextureAtlas.h"
+#include "CpuProfiler.h"
+#include "Texture.h"
+
+// imgui_draw.cpp compiles its own static copy, so does this file
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imgui/stb_rect_pack.h"
+
+#include <algorithm>
+#include <iostream>
+
+TextureAtlas::TextureAtlas(int pageSize, int padding)
+	: m_PageSize(pageSize), m_Padding(1)
+{
+	while (m_Padding < padding) { m_Padding *= 2; }
+}
+
+int TextureAtlas::Add(const std::string& path)
+{
+	std::vector<unsigned char> pixels;
+	int width, height;
+	if (!LoadImageRGBA(path, pixels, width, height))
+	{
+		std::cout << "[TextureAtlas] Can't load " << path << "\n";
+		return -1;
+	}
+	return Add(width, height, pixels.data());
+}
+
+int TextureAtlas::Add(int width, int height, const unsigned char* pixels)
+{
+	ASSERT(m_Pages.empty());
+	m_Images.push_back({ std::vector<unsigned char>(pixels, pixels + (size_t)width * height * 4), width, height });
+	return (int)m_Images.size() - 1;
+}
+
+void TextureAtlas::Build()
+{
+	PROFILE_FUNCTION();
+	ASSERT(m_Pages.empty());
+	m_Regions.assign(m_Images.size(), { 0, glm::vec4(0.0f), 0, 0 });
+
+	// sizes rounded to the padding keep every image on the padding grid
+	std::vector<stbrp_rect> remaining;
+	for (size_t i = 0; i < m_Images.size(); i++)
+	{
+		stbrp_rect rect = {};
+		rect.id = (int)i;
+		rect.w = (m_Images[i].Width + 2 * m_Padding + m_Padding - 1) / m_Padding * m_Padding;
+		rect.h = (m_Images[i].Height + 2 * m_Padding + m_Padding - 1) / m_Padding * m_Padding;
+		if (rect.w > m_PageSize || rect.h > m_PageSize)
+		{
+			std::cout << "[TextureAtlas] Image " << i << " (" << m_Images[i].Width << "x" << m_Images[i].Height
+				<< ") doesn't fit on a " << m_PageSize << " page\n";
+			continue;
+		}
+		remaining.push_back(rect);
+	}
+
+	std::vector<stbrp_node> nodes(m_PageSize);
+	std::vector<unsigned char> page((size_t)m_PageSize * m_PageSize * 4);
+	while (!remaining.empty())
+	{
+		stbrp_context context;
+		stbrp_init_target(&context, m_PageSize, m_PageSize, nodes.data(), (int)nodes.size());
+		stbrp_pack_rects(&context, remaining.data(), (int)remaining.size());
+
+		std::fill(page.begin(), page.end(), 0);
+		std::vector<stbrp_rect> next;
+		for (const stbrp_rect& rect : remaining)
+		{
+			if (!rect.was_packed)
+			{
+				next.push_back(rect);
+				continue;
+			}
+
+			// the gutter repeats the image's outermost pixels
+			const Image& image = m_Images[rect.id];
+			for (int y = -m_Padding; y < image.Height + m_Padding; y++)
+			{
+				int sourceY = std::min(std::max(y, 0), image.Height - 1);
+				for (int x = -m_Padding; x < image.Width + m_Padding; x++)
+				{
+					int sourceX = std::min(std::max(x, 0), image.Width - 1);
+					size_t target = ((size_t)(rect.y + m_Padding + y) * m_PageSize + rect.x + m_Padding + x) * 4;
+					std::copy_n(&image.Pixels[((size_t)sourceY * image.Width + sourceX) * 4], 4, &page[target]);
+				}
+			}
+
+			AtlasRegion& region = m_Regions[rect.id];
+			region.Page = (unsigned int)m_Pages.size();
+			region.Width = image.Width;
+			region.Height = image.Height;
+			region.UV = glm::vec4(rect.x + m_Padding, rect.y + m_Padding,
+				rect.x + m_Padding + image.Width, rect.y + m_Padding + image.Height) / (float)m_PageSize;
+		}
+
+		m_Pages.push_back(std::make_unique<Texture>(m_PageSize, m_PageSize, page.data()));
+		// one mip level per halving of the gutter, past that images start to blend
+		int levels = 1;
+		for (int padding = m_Padding; padding > 1; padding /= 2) { levels++; }
+		m_Pages.back()->GenerateMipmaps(levels);
+		remaining.swap(next);
+	}
+
+	m_Images.clear();
+	m_Images.shrink_to_fit();
+}
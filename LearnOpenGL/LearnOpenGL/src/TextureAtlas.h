@@ -0,0 +1,52 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Texture.h"
+
+#include "glm/glm.hpp"
+
+struct AtlasRegion
+{
+	unsigned int Page;
+	glm::vec4 UV;		// min u, min v, max u, max v
+	int Width, Height;
+};
+
+// Packs many small images into a few large textures (pages) with stb_rect_pack, so objects
+// using different images share one bind and can be batched. Each image gets a gutter of its
+// own edge pixels and sits on a grid of the gutter size, which keeps bilinear filtering and
+// the first log2(padding) mip levels from bleeding into the neighbours.
+class TextureAtlas
+{
+private:
+	struct Image
+	{
+		std::vector<unsigned char> Pixels;
+		int Width, Height;
+	};
+
+	int m_PageSize;
+	int m_Padding;
+	std::vector<Image> m_Images;	// dropped by Build
+	std::vector<AtlasRegion> m_Regions;
+	std::vector<std::unique_ptr<Texture>> m_Pages;
+
+public:
+	// padding is rounded up to a power of two
+	TextureAtlas(int pageSize = 2048, int padding = 4);
+
+	// Index of the image's region once Build has run, -1 if the file can't be loaded
+	int Add(const std::string& path);
+	// RGBA8, rows bottom up like stb_image loads them
+	int Add(int width, int height, const unsigned char* pixels);
+	// Packs everything added so far into pages and uploads them, call once
+	void Build();
+
+	inline const AtlasRegion& GetRegion(int index) const { return m_Regions[index]; }
+	inline const std::vector<AtlasRegion>& GetRegions() const { return m_Regions; }
+	inline unsigned int GetPageCount() const { return (unsigned int)m_Pages.size(); }
+	inline Texture& GetPage(unsigned int page) const { return *m_Pages[page]; }
+};
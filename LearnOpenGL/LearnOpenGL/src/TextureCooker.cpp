@@ -0,0 +1,116 @@
+#include "TextureCooker.h"
+#include "KTX2.h"
+#include "Texture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+// 2x2 box filter, odd sizes fold the last row/column in twice
+static std::vector<unsigned char> Downsample(const std::vector<unsigned char>& source, int width, int height)
+{
+	int mipWidth = std::max(1, width / 2), mipHeight = std::max(1, height / 2);
+	std::vector<unsigned char> mip((size_t)mipWidth * mipHeight * 4);
+	for (int y = 0; y < mipHeight; y++)
+	{
+		int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+		for (int x = 0; x < mipWidth; x++)
+		{
+			int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+			for (int c = 0; c < 4; c++)
+			{
+				int sum = source[((size_t)y0 * width + x0) * 4 + c] + source[((size_t)y0 * width + x1) * 4 + c]
+					+ source[((size_t)y1 * width + x0) * 4 + c] + source[((size_t)y1 * width + x1) * 4 + c];
+				mip[((size_t)y * mipWidth + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+			}
+		}
+	}
+	return mip;
+}
+
+bool CookTexture(const CookOptions& options, CookResult& result)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	if (options.Format != "auto" && options.Format != "bc1" && options.Format != "bc3" && options.Format != "bc7")
+	{
+		std::cout << "[TextureCooker] Unknown format " << options.Format << "\n";
+		return false;
+	}
+
+	// flipped like the runtime stb path uploads, main sets that up
+	std::vector<unsigned char> level;
+	int width, height;
+	if (!LoadImageRGBA(options.Input, level, width, height))
+	{
+		std::cout << "[TextureCooker] Can't load " << options.Input << "\n";
+		return false;
+	}
+
+	KTX2Image image;
+	image.Width = width;
+	image.Height = height;
+	if (options.Format == "bc1") { image.Format = BlockFormat::BC1; }
+	else if (options.Format == "bc3") { image.Format = BlockFormat::BC3; }
+	else if (options.Format == "bc7") { image.Format = BlockFormat::BC7; }
+	else
+	{
+		// auto
+		bool opaque = true;
+		for (size_t i = 3; i < level.size() && opaque; i += 4) { opaque = level[i] == 255; }
+		image.Format = opaque ? BlockFormat::BC1 : BlockFormat::BC7;
+	}
+
+	while (true)
+	{
+		image.Levels.push_back(CompressImage(level.data(), width, height, image.Format, options.Threads));
+		if (!options.Mips || (width == 1 && height == 1)) { break; }
+		level = Downsample(level, width, height);
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+
+	std::string output = options.Output;
+	if (output.empty()) { output = options.Input.substr(0, options.Input.find_last_of('.')) + ".ktx2"; }
+	if (!WriteKTX2(output, image))
+	{
+		std::cout << "[TextureCooker] Can't write " << output << "\n";
+		return false;
+	}
+
+	result.Format = image.Format;
+	result.Width = image.Width;
+	result.Height = image.Height;
+	result.Levels = (unsigned int)image.Levels.size();
+	result.SourceBytes = image.Width * image.Height * 4;
+	result.CookedBytes = 0;
+	for (const std::vector<unsigned char>& data : image.Levels) { result.CookedBytes += (unsigned int)data.size(); }
+	result.Ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	return true;
+}
+
+int RunCooker(const CookOptions& options)
+{
+	CookResult result;
+	if (!CookTexture(options, result)) { return 1; }
+	std::cout << options.Input << ": " << result.Width << "x" << result.Height << " " << GetBlockFormatName(result.Format)
+		<< ", " << result.Levels << " levels, " << result.SourceBytes / 1024 << " KB RGBA8 -> " << result.CookedBytes / 1024
+		<< " KB in " << result.Ms << " ms\n";
+	return 0;
+}
+
+bool ParseCookOptions(int argc, char** argv, CookOptions& options)
+{
+	bool cooking = false;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		std::string value = i + 1 < argc ? argv[i + 1] : "";
+		if (arg == "--cook") { options.Input = value; cooking = true; }
+		else if (arg == "--output") { options.Output = value; }
+		else if (arg == "--format") { options.Format = value; }
+		else if (arg == "--no-mips") { options.Mips = false; }
+		else if (arg == "--threads") { options.Threads = std::stoul(value); }
+	}
+	return cooking && !options.Input.empty();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+
+#include "BlockCompression.h"
+
+// Command line: LearnOpenGL --cook <image> [options]
+//   --output FILE      defaults to the image with a .ktx2 extension
+//   --format F         bc1, bc3, bc7 or auto (bc1 when fully opaque, bc7 otherwise)
+//   --no-mips          level 0 only
+//   --threads N        encoder threads, 0 uses all of them
+struct CookOptions
+{
+	std::string Input;
+	std::string Output;
+	std::string Format = "auto";
+	bool Mips = true;
+	unsigned int Threads = 0;
+};
+
+struct CookResult
+{
+	BlockFormat Format;
+	int Width, Height;
+	unsigned int Levels;
+	unsigned int SourceBytes;	// what the stb path uploads, RGBA8 without mips
+	unsigned int CookedBytes;	// every level
+	double Ms;
+};
+
+// Returns false when the command line doesn't ask for cooking
+bool ParseCookOptions(int argc, char** argv, CookOptions& options);
+// Decodes the image, builds the mip chain, compresses it and writes the KTX2 file
+bool CookTexture(const CookOptions& options, CookResult& result);
+// Cooks and prints a one line report, no GL context needed
+int RunCooker(const CookOptions& options);
@@ -0,0 +1,245 @@
+#include "TextureStreamer.h"
+#include "Texture.h"
+#include "GLStateCache.h"
+#include "ResourceBackend.h"
+#include "CpuProfiler.h"
+#include "StatsOverlay.h"
+#include "stb_image/stb_image.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include "imgui/imgui.h"
+
+// decoding is memory bound past a few threads
+static const unsigned int MAX_DECODE_WORKERS = 4;
+// ring of unpack buffers, enough for uploads in flight over a couple of frames
+static const unsigned int UPLOAD_BUFFER_COUNT = 4;
+
+TextureStreamer::TextureStreamer()
+	: m_Stop(false), m_NextBuffer(0), m_Pending(0), m_Budget(TEXTURE_UPLOAD_BUDGET),
+	m_SliceMs(TEXTURE_UPLOAD_SLICE_MS), m_Stats()
+{
+	unsigned int workers = std::max(1u, std::min(MAX_DECODE_WORKERS, std::thread::hardware_concurrency() - 1));
+	for (unsigned int i = 0; i < workers; i++)
+	{
+		m_Workers.emplace_back(&TextureStreamer::WorkerMain, this);
+	}
+	m_Buffers.resize(UPLOAD_BUFFER_COUNT, { 0, 0, nullptr });
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stop = true;
+	}
+	m_Wake.notify_all();
+	for (std::thread& worker : m_Workers) { worker.join(); }
+
+	// textures still loading keep their placeholder
+	for (auto& request : m_Queue) { Release(*request); }
+	for (auto& request : m_Decoded) { Release(*request); }
+	for (auto& request : m_Uploads) { Release(*request); }
+
+	for (UploadBuffer& buffer : m_Buffers)
+	{
+		if (buffer.Fence) { GLCall(glDeleteSync(buffer.Fence)); }
+		if (buffer.Buffer)
+		{
+			GLStateCache::Get().OnDeleteBuffer(buffer.Buffer);
+			GLCall(glDeleteBuffers(1, &buffer.Buffer));
+		}
+	}
+}
+
+void TextureStreamer::Enqueue(const std::shared_ptr<TextureRequest>& request)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Queue.push_back(request);
+	}
+	m_Pending++;
+	m_Wake.notify_one();
+}
+
+void TextureStreamer::WorkerMain()
+{
+	while (true)
+	{
+		std::shared_ptr<TextureRequest> request;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Wake.wait(lock, [this] { return m_Stop || !m_Queue.empty(); });
+			if (m_Stop) { return; }
+			request = m_Queue.front();
+			m_Queue.pop_front();
+		}
+
+		if (!request->Canceled)
+		{
+			PROFILE_SCOPE("stbi_load");
+			int bpp = 0;
+			request->Pixels = stbi_load(request->Path.c_str(), &request->Width, &request->Height, &bpp, 4);
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Decoded.push_back(request);
+	}
+}
+
+TextureStreamer::UploadBuffer* TextureStreamer::AcquireBuffer(unsigned int size)
+{
+	UploadBuffer& buffer = m_Buffers[m_NextBuffer];
+	if (buffer.Fence)
+	{
+		// the GPU is still reading it, try again next frame
+		GLCall(GLenum status = glClientWaitSync(buffer.Fence, 0, 0));
+		if (status == GL_TIMEOUT_EXPIRED) { return nullptr; }
+		GLCall(glDeleteSync(buffer.Fence));
+		buffer.Fence = nullptr;
+	}
+
+	if (buffer.Buffer == 0) { GLCall(glGenBuffers(1, &buffer.Buffer)); }
+	GLStateCache::Get().BindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.Buffer);
+	if (buffer.Size < size)
+	{
+		GLCall(glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW));
+		buffer.Size = size;
+	}
+	m_NextBuffer = (m_NextBuffer + 1) % UPLOAD_BUFFER_COUNT;
+	return &buffer;
+}
+
+void TextureStreamer::Update()
+{
+	PROFILE_FUNCTION();
+	auto start = std::chrono::high_resolution_clock::now();
+	m_Stats.BytesLastFrame = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Uploads.insert(m_Uploads.end(), m_Decoded.begin(), m_Decoded.end());
+		m_Decoded.clear();
+	}
+
+	bool uploaded = false;
+	while (!m_Uploads.empty())
+	{
+		std::shared_ptr<TextureRequest> request = m_Uploads.front();
+		if (request->Canceled)
+		{
+			Release(*request);
+			m_Uploads.pop_front();
+			m_Pending--;
+			continue;
+		}
+		if (!request->Pixels)
+		{
+			std::cout << "[TextureStreamer] Failed to load " << request->Path << std::endl;
+			request->Target->m_Request.reset();
+			m_Uploads.pop_front();
+			m_Pending--;
+			m_Stats.Failed++;
+			continue;
+		}
+
+		if (request->Storage == 0)
+		{
+			request->Storage = Texture::CreateStorage(request->Width, request->Height, nullptr);
+		}
+
+		// whole rows only, but always at least one a frame so a huge row can't stall the load
+		unsigned int rowBytes = request->Width * 4;
+		unsigned int left = m_Budget > m_Stats.BytesLastFrame ? m_Budget - m_Stats.BytesLastFrame : 0;
+		if (left < rowBytes && uploaded) { break; }
+		int rows = std::min(request->Height - request->RowsUploaded, std::max(1, (int)(left / rowBytes)));
+		unsigned int size = rows * rowBytes;
+
+		UploadBuffer* buffer = AcquireBuffer(size);
+		if (!buffer) { break; }
+		{
+			PROFILE_SCOPE("Texture stripe upload");
+			GLCall(void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+				GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+			if (!mapped) { break; }
+			std::memcpy(mapped, request->Pixels + (size_t)request->RowsUploaded * rowBytes, size);
+			GLCall(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+
+			// offset 0 into the bound unpack buffer
+			if (UseDirectStateAccess())
+			{
+				GLCall(glTextureSubImage2D(request->Storage, 0, 0, request->RowsUploaded, request->Width, rows, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+			}
+			else
+			{
+				GLStateCache::Get().BindTexture(GL_TEXTURE_2D, request->Storage);
+				GLCall(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, request->RowsUploaded, request->Width, rows, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+			}
+			GLCall(buffer->Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+		}
+		request->RowsUploaded += rows;
+		m_Stats.BytesLastFrame += size;
+		uploaded = true;
+
+		if (request->RowsUploaded == request->Height)
+		{
+			Complete(*request);
+			m_Uploads.pop_front();
+			m_Pending--;
+		}
+
+		double elapsed = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		if (elapsed >= m_SliceMs || m_Stats.BytesLastFrame >= m_Budget) { break; }
+	}
+
+	// uploads from client memory elsewhere must not read from our buffers
+	GLStateCache::Get().BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	if (uploaded) { GLStateCache::Get().BindTexture(GL_TEXTURE_2D, 0); }
+	m_Stats.UploadMsLastFrame = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void TextureStreamer::Complete(TextureRequest& request)
+{
+	// the texture switches objects, later binds pick up the new one. Every stripe was
+	// issued before this, GL orders them ahead of any draw that samples the texture
+	Texture& texture = *request.Target;
+	GLStateCache::Get().OnDeleteTexture(texture.m_RendererID);
+	GLCall(glDeleteTextures(1, &texture.m_RendererID));
+	texture.m_RendererID = request.Storage;
+	texture.m_Width = request.Width;
+	texture.m_Height = request.Height;
+	texture.m_BPP = 4;
+	texture.m_MemorySize = request.Width * request.Height * 4;
+	request.Storage = 0;
+	stbi_image_free(request.Pixels);
+	request.Pixels = nullptr;
+	m_Stats.Completed++;
+	// drops the texture's reference last, we still hold one
+	texture.m_Request.reset();
+}
+
+void TextureStreamer::Release(TextureRequest& request)
+{
+	if (request.Pixels) { stbi_image_free(request.Pixels); }
+	request.Pixels = nullptr;
+	if (request.Storage)
+	{
+		GLStateCache::Get().OnDeleteTexture(request.Storage);
+		GLCall(glDeleteTextures(1, &request.Storage));
+		request.Storage = 0;
+	}
+}
+
+void TextureStreamer::OnImGuiRender()
+{
+	BeginStatsSection();
+	ImGui::Text("Textures streamed: %u (%u failed), %u pending", m_Stats.Completed, m_Stats.Failed, m_Pending);
+	if (m_Pending > 0)
+	{
+		ImGui::Text("%.1f KB in %.2f ms last frame (budget %.1f KB / %.1f ms)", m_Stats.BytesLastFrame / 1024.0f,
+			m_Stats.UploadMsLastFrame, m_Budget / 1024.0f, m_SliceMs);
+	}
+	EndStatsOverlay();
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Renderer.h"
+
+class Texture;
+
+// default per frame limits of Update, whichever is reached first
+const unsigned int TEXTURE_UPLOAD_BUDGET = 4 * 1024 * 1024;
+const double TEXTURE_UPLOAD_SLICE_MS = 2.0;
+
+// One Texture::LoadAsync, shared between the texture and the streamer
+struct TextureRequest
+{
+	std::string Path;
+	Texture* Target;			// main thread only, cleared when the texture dies first
+	std::atomic<bool> Canceled;
+	unsigned char* Pixels;		// RGBA8, written by the decoding worker
+	int Width, Height;
+	unsigned int Storage;		// full size texture the rows go into, replaces the placeholder when done
+	int RowsUploaded;
+};
+
+struct TextureStreamerStats
+{
+	unsigned int Completed;
+	unsigned int Failed;
+	unsigned int BytesLastFrame;
+	double UploadMsLastFrame;
+};
+
+// Streams textures in without stalling the main thread. Worker threads decode files with
+// stb_image, Update (main thread, once per frame) copies the decoded rows into a small ring
+// of pixel unpack buffers and issues glTexSubImage2D from them. Every frame stops at the
+// byte budget or the time slice, so a big texture is spread over several frames.
+class TextureStreamer
+{
+private:
+	struct UploadBuffer
+	{
+		unsigned int Buffer;
+		unsigned int Size;
+		GLsync Fence;	// last upload out of the buffer, it's only rewritten once that finished
+	};
+
+	std::vector<std::thread> m_Workers;
+	std::mutex m_Mutex;
+	std::condition_variable m_Wake;
+	std::deque<std::shared_ptr<TextureRequest>> m_Queue;	// waiting for a worker
+	std::deque<std::shared_ptr<TextureRequest>> m_Decoded;	// waiting for Update
+	bool m_Stop;
+
+	// main thread only
+	std::deque<std::shared_ptr<TextureRequest>> m_Uploads;
+	std::vector<UploadBuffer> m_Buffers;
+	unsigned int m_NextBuffer;
+	unsigned int m_Pending;
+	unsigned int m_Budget;
+	double m_SliceMs;
+	TextureStreamerStats m_Stats;
+
+	void WorkerMain();
+	UploadBuffer* AcquireBuffer(unsigned int size);
+	void Complete(TextureRequest& request);
+	static void Release(TextureRequest& request);
+
+public:
+	TextureStreamer();
+	~TextureStreamer();
+
+	// Called by Texture::LoadAsync
+	void Enqueue(const std::shared_ptr<TextureRequest>& request);
+	void Update();
+
+	inline void SetUploadBudget(unsigned int bytes) { m_Budget = bytes; }
+	inline void SetTimeSlice(double ms) { m_SliceMs = ms; }
+	// loads not finished yet, queued, decoding or uploading
+	inline unsigned int GetPendingCount() const { return m_Pending; }
+	inline const TextureStreamerStats& GetStats() const { return m_Stats; }
+
+	void OnImGuiRender();
+};
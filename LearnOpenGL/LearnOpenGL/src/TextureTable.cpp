@@ -0,0 +1,104 @@
+#include "TextureTable.h"
+#include "Renderer.h"
+#include "Texture.h"
+#include "TextureArray.h"
+#include "UniformBuffer.h"
+#include "UniformBlocks.h"
+
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+
+// ARB_bindless_texture isn't in the glad loader, fetched by hand
+typedef GLuint64 (APIENTRYP GetTextureHandleProc)(GLuint texture);
+typedef void (APIENTRYP MakeTextureHandleResidentProc)(GLuint64 handle);
+typedef void (APIENTRYP MakeTextureHandleNonResidentProc)(GLuint64 handle);
+static GetTextureHandleProc s_GetTextureHandle = nullptr;
+static MakeTextureHandleResidentProc s_MakeTextureHandleResident = nullptr;
+static MakeTextureHandleNonResidentProc s_MakeTextureHandleNonResident = nullptr;
+
+TextureTable::TextureTable(int width, int height, unsigned int capacity, Mode preferred)
+	: m_Mode(MODE_ARRAY), m_Width(width), m_Height(height), m_Capacity(capacity), m_Count(0)
+{
+	if (preferred == MODE_BINDLESS && glfwExtensionSupported("GL_ARB_bindless_texture"))
+	{
+		s_GetTextureHandle = (GetTextureHandleProc)glfwGetProcAddress("glGetTextureHandleARB");
+		s_MakeTextureHandleResident = (MakeTextureHandleResidentProc)glfwGetProcAddress("glMakeTextureHandleResidentARB");
+		s_MakeTextureHandleNonResident = (MakeTextureHandleNonResidentProc)glfwGetProcAddress("glMakeTextureHandleNonResidentARB");
+		if (s_GetTextureHandle && s_MakeTextureHandleResident && s_MakeTextureHandleNonResident)
+		{
+			m_Mode = MODE_BINDLESS;
+			m_HandleBuffer = std::make_unique<UniformBuffer>(capacity * sizeof(uint64_t), TEXTURE_HANDLES_BINDING, GL_SHADER_STORAGE_BUFFER);
+			return;
+		}
+	}
+	m_Array = std::make_unique<TextureArray>(width, height, capacity);
+}
+
+TextureTable::~TextureTable()
+{
+	// a resident handle keeps its texture alive, release them before the textures go
+	for (uint64_t handle : m_Handles)
+	{
+		GLCall(s_MakeTextureHandleNonResident(handle));
+	}
+}
+
+int TextureTable::Add(const unsigned char* pixels)
+{
+	if (m_Mode == MODE_ARRAY)
+	{
+		int layer = m_Array->Add(pixels);
+		m_Count += layer >= 0 ? 1 : 0;
+		return layer;
+	}
+
+	if (m_Count == m_Capacity)
+	{
+		std::cout << "[TextureTable] Full, all " << m_Capacity << " entries are used\n";
+		return -1;
+	}
+	m_Textures.push_back(std::make_unique<Texture>(m_Width, m_Height, pixels));
+	// the texture's parameters are frozen from here on
+	GLCall(uint64_t handle = s_GetTextureHandle(m_Textures.back()->GetRendererID()));
+	GLCall(s_MakeTextureHandleResident(handle));
+	m_Handles.push_back(handle);
+	m_HandleBuffer->SetData(&handle, sizeof(handle), m_Count * sizeof(uint64_t));
+	return (int)m_Count++;
+}
+
+int TextureTable::Add(const std::string& path)
+{
+	std::vector<unsigned char> pixels;
+	int width, height;
+	if (!LoadImageRGBA(path, pixels, width, height) || width != m_Width || height != m_Height)
+	{
+		std::cout << "[TextureTable] " << path << " doesn't load as " << m_Width << "x" << m_Height << "\n";
+		return -1;
+	}
+	return Add(pixels.data());
+}
+
+void TextureTable::Bind(unsigned int slot) const
+{
+	if (m_Mode == MODE_ARRAY) { m_Array->Bind(slot); }
+	else { m_HandleBuffer->Bind(); }
+}
+
+ShaderDefines TextureTable::GetDefines() const
+{
+	ShaderDefines defines;
+	defines.Set("TEXTURE_TABLE");
+	if (m_Mode == MODE_BINDLESS) { defines.Set("BINDLESS"); }
+	return defines;
+}
+
+const char* TextureTable::GetModeName(Mode mode)
+{
+	switch (mode)
+	{
+		case MODE_ARRAY: return "texture array";
+		case MODE_BINDLESS: return "bindless";
+	}
+	return "unknown";
+}
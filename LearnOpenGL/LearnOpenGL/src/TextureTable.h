@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ShaderPreprocessor.h"
+
+class Texture;
+class TextureArray;
+class UniformBuffer;
+
+// Textures that shaders pick by index, so draws using different textures need no rebind
+// in between and a whole scene can go out as one instanced draw.
+//   MODE_BINDLESS  ARB_bindless_texture, every texture's 64 bit handle sits in the
+//                  TextureHandles storage block and shaders turn it into a sampler2D
+//   MODE_ARRAY     one TextureArray, the index is the layer. Used when the driver has
+//                  no bindless support.
+// Textures must all have the table's size either way, so both modes behave the same.
+// Shaders compile with GetDefines(): TEXTURE_TABLE, plus BINDLESS in bindless mode.
+class TextureTable
+{
+public:
+	enum Mode { MODE_ARRAY = 0, MODE_BINDLESS };
+
+private:
+	Mode m_Mode;
+	int m_Width, m_Height;
+	unsigned int m_Capacity;
+	unsigned int m_Count;
+
+	std::unique_ptr<TextureArray> m_Array;
+	std::vector<std::unique_ptr<Texture>> m_Textures;
+	std::vector<uint64_t> m_Handles;
+	std::unique_ptr<UniformBuffer> m_HandleBuffer;
+
+public:
+	TextureTable(int width, int height, unsigned int capacity, Mode preferred = MODE_BINDLESS);
+	~TextureTable();
+
+	// Index of the new texture, -1 when the table is full or the size doesn't match
+	int Add(const unsigned char* pixels);
+	int Add(const std::string& path);
+
+	// The array on a texture unit, or the handle block on its binding point
+	void Bind(unsigned int slot) const;
+
+	ShaderDefines GetDefines() const;
+	inline Mode GetMode() const { return m_Mode; }
+	inline unsigned int GetCount() const { return m_Count; }
+	static const char* GetModeName(Mode mode);
+};
@@ -0,0 +1,211 @@
+#include "UiCache.h"
+#include "Renderer.h"
+#include "GLStateCache.h"
+#include "ShaderLibrary.h"
+#include "CpuProfiler.h"
+#include "StatsOverlay.h"
+
+#include <GLFW/glfw3.h>
+
+#include <cstring>
+
+#include "imgui/imgui.h"
+#include "imgui/imgui_impl_glfw_gl3.h"
+
+static const char* COMPOSITE_SHADER_PATH = "resources/shaders/Composite.shader";
+
+// FNV-1a over 64 bit words, the tail byte by byte. A frame of UI is a few hundred KB and
+// gets hashed every time it's built, byte at a time would cost more than drawing it.
+static uint64_t HashBytes(const void* data, size_t size, uint64_t hash)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	size_t words = size / 8;
+	for (size_t i = 0; i < words; i++)
+	{
+		uint64_t word;
+		std::memcpy(&word, bytes + i * 8, 8);
+		hash = (hash ^ word) * 1099511628211ull;
+	}
+	for (size_t i = words * 8; i < size; i++) { hash = (hash ^ bytes[i]) * 1099511628211ull; }
+	return hash;
+}
+
+// Everything the backend draws from, false when a command has a callback that may draw anything
+static bool HashDrawData(const ImDrawData* drawData, uint64_t& hash)
+{
+	hash = 14695981039346656037ull;
+	for (int n = 0; n < drawData->CmdListsCount; n++)
+	{
+		const ImDrawList* list = drawData->CmdLists[n];
+		hash = HashBytes(list->VtxBuffer.Data, list->VtxBuffer.Size * sizeof(ImDrawVert), hash);
+		hash = HashBytes(list->IdxBuffer.Data, list->IdxBuffer.Size * sizeof(ImDrawIdx), hash);
+		for (const ImDrawCmd& command : list->CmdBuffer)
+		{
+			if (command.UserCallback) { return false; }
+			hash = HashBytes(&command.ClipRect, sizeof(command.ClipRect), hash);
+			hash = HashBytes(&command.TextureId, sizeof(command.TextureId), hash);
+			hash = HashBytes(&command.ElemCount, sizeof(command.ElemCount), hash);
+		}
+	}
+	return true;
+}
+
+UiCache::UiCache(ShaderLibrary& shaders, bool enabled)
+	: m_Shader(shaders.Get(COMPOSITE_SHADER_PATH)), m_Hash(0), m_Valid(false), m_Enabled(enabled),
+	m_LastBuild(0.0), m_LastInput(0.0), m_CursorX(0.0), m_CursorY(0.0), m_Stats(),
+	m_RateStats(), m_RateTime(0.0), m_HitRate(0.0f)
+{
+}
+
+bool UiCache::HasInput(GLFWwindow* window)
+{
+	double x, y;
+	glfwGetCursorPos(window, &x, &y);
+	bool moved = x != m_CursorX || y != m_CursorY;
+	m_CursorX = x;
+	m_CursorY = y;
+	if (moved) { return true; }
+
+	for (int button = GLFW_MOUSE_BUTTON_1; button <= GLFW_MOUSE_BUTTON_3; button++)
+	{
+		if (glfwGetMouseButton(window, button) == GLFW_PRESS) { return true; }
+	}
+	// the backend's callbacks queue these up until the next NewFrame, a text field blinks its cursor
+	const ImGuiIO& io = ImGui::GetIO();
+	if (io.MouseWheel != 0.0f || io.MouseWheelH != 0.0f || io.InputCharacters[0] != 0 || io.WantTextInput) { return true; }
+	for (bool down : io.KeysDown)
+	{
+		if (down) { return true; }
+	}
+	return false;
+}
+
+bool UiCache::BeginFrame(GLFWwindow* window)
+{
+	if (!m_Enabled) { return true; }
+
+	double time = glfwGetTime();
+	if (HasInput(window)) { m_LastInput = time; }
+	int width, height;
+	glfwGetFramebufferSize(window, &width, &height);
+	bool resized = !m_Target || m_Target->GetWidth() != width || m_Target->GetHeight() != height;
+	bool idle = time - m_LastInput >= UI_CACHE_IDLE_DELAY;
+	if (!m_Valid || resized || !idle || time - m_LastBuild >= UI_CACHE_IDLE_INTERVAL)
+	{
+		m_LastBuild = time;
+		return true;
+	}
+	return false;
+}
+
+void UiCache::Render(ImDrawData* drawData)
+{
+	PROFILE_FUNCTION();
+	m_Stats.Frames++;
+	if (!m_Enabled)
+	{
+		if (drawData) { ImGui_ImplGlfwGL3_RenderDrawData(drawData); }
+		return;
+	}
+
+	const ImGuiIO& io = ImGui::GetIO();
+	int width = (int)(io.DisplaySize.x * io.DisplayFramebufferScale.x);
+	int height = (int)(io.DisplaySize.y * io.DisplayFramebufferScale.y);
+	// minimized
+	if (width <= 0 || height <= 0) { return; }
+	if (!drawData)
+	{
+		m_Stats.Skipped++;
+		Composite();
+		return;
+	}
+
+	uint64_t hash;
+	bool hashed = HashDrawData(drawData, hash);
+	bool resized = !m_Target || m_Target->GetWidth() != width || m_Target->GetHeight() != height;
+	if (hashed && m_Valid && !resized && hash == m_Hash)
+	{
+		m_Stats.Hits++;
+		Composite();
+		return;
+	}
+
+	if (!m_Target) { m_Target = std::make_unique<Framebuffer>(width, height); }
+	m_Target->Resize(width, height);
+
+	GLStateCache& cache = GLStateCache::Get();
+	int viewport[4];
+	if (!cache.GetViewport(viewport)) { GLCall(glGetIntegerv(GL_VIEWPORT, viewport)); }
+	m_Target->Bind();
+	const float transparent[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	GLCall(glClearBufferfv(GL_COLOR, 0, transparent));
+	ImGui_ImplGlfwGL3_RenderDrawData(drawData);
+	m_Target->Unbind();
+	cache.SetViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+	m_Hash = hash;
+	m_Valid = hashed;
+	m_Stats.Renders++;
+	Composite();
+}
+
+void UiCache::Composite()
+{
+	GLStateCache& cache = GLStateCache::Get();
+	// the app's depth test and blending are put back afterwards
+	int depthTest = cache.IsEnabled(GL_DEPTH_TEST), blend = cache.IsEnabled(GL_BLEND);
+	if (depthTest < 0) { GLCall(depthTest = glIsEnabled(GL_DEPTH_TEST)); }
+	if (blend < 0) { GLCall(blend = glIsEnabled(GL_BLEND)); }
+	unsigned int factors[4];
+	if (!cache.GetBlendFuncSeparate(factors))
+	{
+		GLCall(glGetIntegerv(GL_BLEND_SRC_RGB, (GLint*)&factors[0]));
+		GLCall(glGetIntegerv(GL_BLEND_DST_RGB, (GLint*)&factors[1]));
+		GLCall(glGetIntegerv(GL_BLEND_SRC_ALPHA, (GLint*)&factors[2]));
+		GLCall(glGetIntegerv(GL_BLEND_DST_ALPHA, (GLint*)&factors[3]));
+	}
+
+	// the cached image is premultiplied
+	cache.SetEnabled(GL_DEPTH_TEST, false);
+	cache.SetEnabled(GL_BLEND, true);
+	cache.SetBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	m_Shader.Bind();
+	m_VertexArray.Bind();
+	cache.ActiveTexture(0);
+	cache.BindTexture(GL_TEXTURE_2D, m_Target->GetColorAttachment());
+	GLCall(glDrawArrays(GL_TRIANGLES, 0, 3));
+
+	cache.SetEnabled(GL_DEPTH_TEST, depthTest != 0);
+	cache.SetEnabled(GL_BLEND, blend != 0);
+	cache.SetBlendFuncSeparate(factors[0], factors[1], factors[2], factors[3]);
+}
+
+void UiCache::SetEnabled(bool enabled)
+{
+	m_Enabled = enabled;
+	m_Valid = false;
+}
+
+void UiCache::OnImGuiRender()
+{
+	// hit rate over about the last second
+	double time = glfwGetTime();
+	if (time - m_RateTime >= 1.0)
+	{
+		unsigned int frames = m_Stats.Frames - m_RateStats.Frames;
+		unsigned int hits = m_Stats.Skipped + m_Stats.Hits - m_RateStats.Skipped - m_RateStats.Hits;
+		m_HitRate = frames ? 100.0f * hits / frames : 0.0f;
+		m_RateStats = m_Stats;
+		m_RateTime = time;
+	}
+
+	BeginStatsSection();
+	bool enabled = m_Enabled;
+	if (ImGui::Checkbox("Retained UI", &enabled)) { SetEnabled(enabled); }
+	if (m_Enabled)
+	{
+		ImGui::Text("UI cache: %.1f%% hit rate, %u skipped, %u unchanged, %u rendered", m_HitRate,
+			m_Stats.Skipped, m_Stats.Hits, m_Stats.Renders);
+	}
+	EndStatsOverlay();
+}
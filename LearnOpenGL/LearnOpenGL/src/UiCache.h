@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "Framebuffer.h"
+#include "VertexArray.h"
+
+struct GLFWwindow;
+struct ImDrawData;
+class Shader;
+class ShaderLibrary;
+
+// how often an idle UI is rebuilt, the scene keeps its own rate
+const double UI_CACHE_IDLE_INTERVAL = 0.1;
+// input keeps the UI rebuilding every frame until it has been quiet this long
+const double UI_CACHE_IDLE_DELAY = 0.5;
+
+struct UiCacheStats
+{
+	unsigned int Frames;
+	unsigned int Skipped;	// frames that didn't build the UI at all
+	unsigned int Hits;		// built, but the draw data hashed the same as the cached image
+	unsigned int Renders;	// drawn into the cache again
+};
+
+// Retained UI: ImGui draws into an offscreen texture that is composited over the scene every
+// frame. A frame whose ImDrawData (vertices, indices, clip rects, textures) hashes the same as
+// the cached one at the same size only composites. While there's no input the UI is rebuilt
+// every UI_CACHE_IDLE_INTERVAL seconds instead of every frame. Draw data with user callbacks
+// can't be hashed, it's rendered and rebuilt every frame. Disabled, Render just draws ImGui.
+class UiCache
+{
+private:
+	Shader& m_Shader;
+	VertexArray m_VertexArray;	// empty, the composite triangle comes from gl_VertexID
+	std::unique_ptr<Framebuffer> m_Target;
+	uint64_t m_Hash;
+	bool m_Valid;				// the target holds the last built frame
+	bool m_Enabled;
+	double m_LastBuild, m_LastInput;
+	double m_CursorX, m_CursorY;
+	UiCacheStats m_Stats;
+	UiCacheStats m_RateStats;	// m_Stats when the hit rate was last worked out
+	double m_RateTime;
+	float m_HitRate;
+
+	bool HasInput(GLFWwindow* window);
+	void Composite();
+
+public:
+	UiCache(ShaderLibrary& shaders, bool enabled);
+
+	// Whether this frame builds the UI (NewFrame through ImGui::Render)
+	bool BeginFrame(GLFWwindow* window);
+	// The frame's draw data when BeginFrame said to build it, nullptr otherwise
+	void Render(ImDrawData* drawData);
+
+	void SetEnabled(bool enabled);
+	inline bool IsEnabled() const { return m_Enabled; }
+	inline const UiCacheStats& GetStats() const { return m_Stats; }
+	void OnImGuiRender();
+};
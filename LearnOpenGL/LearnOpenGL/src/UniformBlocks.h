@@ -0,0 +1,44 @@
+#pragma once
+
+#include "BlockLayout.h"
+
+// Binding points shared by every shader, Shader binds blocks with these names on link
+const unsigned int CAMERA_BLOCK_BINDING = 0;
+// std430 buffer AtlasRegions { vec4 u_AtlasRegions[]; }, one TextureAtlas region per instance
+const unsigned int ATLAS_REGIONS_BINDING = 1;
+// std430 buffer TextureHandles { uvec2 u_TextureHandles[]; }, bindless handles of a TextureTable
+const unsigned int TEXTURE_HANDLES_BINDING = 2;
+// std430 buffer InstanceTextures { uint u_InstanceTextures[]; }, TextureTable index per instance
+const unsigned int INSTANCE_TEXTURES_BINDING = 3;
+// std430 buffer DrawData { DrawRecord u_Draws[]; }, per-draw data of RenderQueue multi draws
+const unsigned int DRAW_DATA_BINDING = 4;
+
+// layout(std140) uniform Camera, uploaded once per frame by Renderer::BeginScene
+struct CameraBlock
+{
+	glm::mat4 View;
+	glm::mat4 Projection;
+	glm::mat4 ViewProjection;
+	float Time;
+	float Padding[3];
+};
+
+using CameraBlockLayout = BlockDescription<BlockLayout::Std140, glm::mat4, glm::mat4, glm::mat4, float>;
+BLOCK_MEMBER_CHECK(CameraBlock, View, CameraBlockLayout, 0);
+BLOCK_MEMBER_CHECK(CameraBlock, Projection, CameraBlockLayout, 1);
+BLOCK_MEMBER_CHECK(CameraBlock, ViewProjection, CameraBlockLayout, 2);
+BLOCK_MEMBER_CHECK(CameraBlock, Time, CameraBlockLayout, 3);
+BLOCK_SIZE_CHECK(CameraBlock, CameraBlockLayout);
+
+// struct DrawRecord { mat4 Model; uint Material; }, an element of the DrawData array
+struct DrawDataRecord
+{
+	glm::mat4 Model;
+	unsigned int Material;
+	unsigned int Padding[3];
+};
+
+using DrawDataRecordLayout = BlockDescription<BlockLayout::Std430, glm::mat4, unsigned int>;
+BLOCK_MEMBER_CHECK(DrawDataRecord, Model, DrawDataRecordLayout, 0);
+BLOCK_MEMBER_CHECK(DrawDataRecord, Material, DrawDataRecordLayout, 1);
+BLOCK_SIZE_CHECK(DrawDataRecord, DrawDataRecordLayout);
@@ -0,0 +1,60 @@
+#include "UniformBuffer.h"
+#include "Renderer.h"
+#include "GLStateCache.h"
+#include "UniformBlocks.h"
+
+#include <unordered_map>
+
+static std::unordered_map<std::string, unsigned int>& GetBlockRegistry()
+{
+	// built-in blocks are registered up front so shaders created before any buffer still bind them
+	static std::unordered_map<std::string, unsigned int> registry = {
+		{ "Camera", CAMERA_BLOCK_BINDING },
+		{ "AtlasRegions", ATLAS_REGIONS_BINDING },
+		{ "TextureHandles", TEXTURE_HANDLES_BINDING },
+		{ "InstanceTextures", INSTANCE_TEXTURES_BINDING },
+		{ "DrawData", DRAW_DATA_BINDING },
+	};
+	return registry;
+}
+
+UniformBuffer::UniformBuffer(unsigned int size, unsigned int binding, unsigned int target)
+	: m_Size(size), m_Binding(binding), m_Target(target)
+{
+	GLCall(glGenBuffers(1, &m_RendererID));
+	GLStateCache::Get().BindBuffer(m_Target, m_RendererID);
+	GLCall(glBufferData(m_Target, size, nullptr, GL_DYNAMIC_DRAW));
+	Bind();
+}
+
+UniformBuffer::~UniformBuffer()
+{
+	GLStateCache::Get().OnDeleteBuffer(m_RendererID);
+	GLCall(glDeleteBuffers(1, &m_RendererID));
+}
+
+void UniformBuffer::SetData(const void* data, unsigned int size, unsigned int offset)
+{
+	ASSERT(offset + size <= m_Size);
+	GLStateCache::Get().BindBuffer(m_Target, m_RendererID);
+	GLCall(glBufferSubData(m_Target, offset, size, data));
+}
+
+void UniformBuffer::Bind() const
+{
+	// glBindBufferBase also changes the generic binding, keep the cache in sync
+	GLCall(glBindBufferBase(m_Target, m_Binding, m_RendererID));
+	GLStateCache::Get().OnBindBufferBase(m_Target, m_RendererID);
+}
+
+void UniformBuffer::RegisterBlock(const std::string& name, unsigned int binding)
+{
+	GetBlockRegistry()[name] = binding;
+}
+
+int UniformBuffer::GetBlockBinding(const std::string& name)
+{
+	auto& registry = GetBlockRegistry();
+	auto it = registry.find(name);
+	return it != registry.end() ? (int)it->second : -1;
+}
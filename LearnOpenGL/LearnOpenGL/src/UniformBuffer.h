@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <glad/glad.h>
+
+// GPU block bound to a fixed indexed binding point. Uniform blocks use std140,
+// pass GL_SHADER_STORAGE_BUFFER as target for std430 storage blocks.
+class UniformBuffer
+{
+private:
+	unsigned int m_RendererID;
+	unsigned int m_Size;
+	unsigned int m_Binding;
+	unsigned int m_Target;
+
+public:
+	UniformBuffer(unsigned int size, unsigned int binding, unsigned int target = GL_UNIFORM_BUFFER);
+	~UniformBuffer();
+
+	// Updates part of the block, offset and size come from the matching BlockDescription
+	void SetData(const void* data, unsigned int size, unsigned int offset = 0);
+
+	// Attaches the buffer to its binding point, done on creation and again after anything rebinds it
+	void Bind() const;
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline unsigned int GetSize() const { return m_Size; }
+	inline unsigned int GetBinding() const { return m_Binding; }
+
+	// Binding point for a named block, -1 if the block is not registered.
+	// Shader looks every active block up here after linking.
+	static void RegisterBlock(const std::string& name, unsigned int binding);
+	static int GetBlockBinding(const std::string& name);
+};
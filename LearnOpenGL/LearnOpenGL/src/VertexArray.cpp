@@ -1,46 +1,74 @@
 #include "VertexArray.h"
 #include "Renderer.h"
 #include "VertexBufferLayout.h"
+#include "GLStateCache.h"
 
 VertexArray::VertexArray()
+	: m_AttribCount(0), m_InstanceAttribIndex(0), m_InstanceBufferID(0)
 {
 	GLCall(glGenVertexArrays(1, &m_RendererID));
 }
 
 VertexArray::~VertexArray()
 {
-	GLCall(glDeleteVertexArrays(1, &m_RendererID))
+	GLStateCache::Get().OnDeleteVertexArray(m_RendererID);
+	GLCall(glDeleteVertexArrays(1, &m_RendererID));
 }
 
 void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout)
+{
+	m_AttribCount = SetAttributes(vb.GetRendererID(), layout, m_AttribCount);
+}
+
+void VertexArray::SetInstanceBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout)
+{
+	SetInstanceBuffer(vb.GetRendererID(), layout);
+}
+
+void VertexArray::SetInstanceBuffer(unsigned int buffer, const VertexBufferLayout& layout)
+{
+	if (m_InstanceBufferID == buffer) { return; }
+
+	if (m_InstanceBufferID == 0)
+	{
+		m_InstanceAttribIndex = m_AttribCount;
+	}
+	m_AttribCount = SetAttributes(buffer, layout, m_InstanceAttribIndex);
+	m_InstanceBufferID = buffer;
+}
+
+unsigned int VertexArray::SetAttributes(unsigned int buffer, const VertexBufferLayout& layout, unsigned int firstIndex)
 {
 	Bind();
-	vb.Bind();
+	GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, buffer);
 	const auto& elements = layout.GetElements();
 	unsigned int offset = 0, i = 0;
 
 	for (i = 0; i < elements.size(); i++)
 	{
 		const auto& element = elements[i];
-		GLCall(glEnableVertexAttribArray(i));
+		GLCall(glEnableVertexAttribArray(firstIndex + i));
 		GLCall(glVertexAttribPointer(
-			i,
+			firstIndex + i,
 			element.count,
 			element.type,
 			element.normalized,
 			layout.GetStride(),
 			(const void*) offset)
 		);
+		GLCall(glVertexAttribDivisor(firstIndex + i, element.divisor));
 		offset += element.count * VertexBufferElement::GetSizeOfType(element.type);
 	}
+
+	return firstIndex + i;
 }
 
 void VertexArray::Bind() const
 {
-	GLCall(glBindVertexArray(m_RendererID));
+	GLStateCache::Get().BindVertexArray(m_RendererID);
 }
 
 void VertexArray::Unbind() const
 {
-	GLCall(glBindVertexArray(0));
+	GLStateCache::Get().BindVertexArray(0);
 }
@@ -8,12 +8,24 @@ class VertexArray
 {
 private:
 	unsigned int m_RendererID;
+	unsigned int m_AttribCount;
+	// per-instance attributes live after the per-vertex ones and can be re-pointed
+	unsigned int m_InstanceAttribIndex;
+	unsigned int m_InstanceBufferID;
+
+	unsigned int SetAttributes(unsigned int buffer, const VertexBufferLayout& layout, unsigned int firstIndex);
 
 public:
 	VertexArray();
 	~VertexArray();
 
 	void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout);
+	void SetInstanceBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout);
+	// Any GL buffer, e.g. a StreamBuffer. Attributes start at its beginning, draws pick
+	// their first instance with baseInstance
+	void SetInstanceBuffer(unsigned int buffer, const VertexBufferLayout& layout);
 	void Bind() const;
 	void Unbind() const;
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
 };
\ No newline at end of file
@@ -1,24 +1,73 @@
 #include "VertexBuffer.h"
 #include "Renderer.h"
+#include "GLStateCache.h"
+#include "ResourceBackend.h"
 
 VertexBuffer::VertexBuffer(const void * data, unsigned int size)
+	: m_Size(size), m_Immutable(false)
 {
+	if (UseDirectStateAccess())
+	{
+		m_Immutable = true;
+		GLCall(glCreateBuffers(1, &m_RendererID));
+		// no flags, the contents never change after this
+		GLCall(glNamedBufferStorage(m_RendererID, size, data, 0));
+		return;
+	}
+
 	GLCall(glGenBuffers(1, &m_RendererID));
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
+	GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, m_RendererID);
 	GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
 }
 
+// Dynamic buffer, filled later through SetData
+VertexBuffer::VertexBuffer(unsigned int size)
+	: m_Size(size), m_Immutable(false)
+{
+	// stays mutable under DSA too, SetData orphans and grows it
+	if (UseDirectStateAccess())
+	{
+		GLCall(glCreateBuffers(1, &m_RendererID));
+		GLCall(glNamedBufferData(m_RendererID, size, nullptr, GL_STREAM_DRAW));
+		return;
+	}
+
+	GLCall(glGenBuffers(1, &m_RendererID));
+	GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, m_RendererID);
+	GLCall(glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW));
+}
+
 VertexBuffer::~VertexBuffer()
 {
+	GLStateCache::Get().OnDeleteBuffer(m_RendererID);
 	GLCall(glDeleteBuffers(1, &m_RendererID));
 }
 
+void VertexBuffer::SetData(const void* data, unsigned int size)
+{
+	// glNamedBufferData on immutable storage is GL_INVALID_OPERATION
+	ASSERT(!m_Immutable);
+	// orphan the old storage so we don't stall on draws still reading it,
+	// growing it if needed (the buffer name stays the same)
+	if (size > m_Size) { m_Size = size; }
+	if (UseDirectStateAccess())
+	{
+		GLCall(glNamedBufferData(m_RendererID, m_Size, nullptr, GL_STREAM_DRAW));
+		GLCall(glNamedBufferSubData(m_RendererID, 0, size, data));
+		return;
+	}
+
+	Bind();
+	GLCall(glBufferData(GL_ARRAY_BUFFER, m_Size, nullptr, GL_STREAM_DRAW));
+	GLCall(glBufferSubData(GL_ARRAY_BUFFER, 0, size, data));
+}
+
 void VertexBuffer::Bind() const
 {
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
+	GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, m_RendererID);
 }
 
 void VertexBuffer::Unbind() const
 {
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+	GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, 0);
 }
@@ -4,11 +4,22 @@ class VertexBuffer
 {
 private:
 	unsigned int m_RendererID;
+	unsigned int m_Size;
+	bool m_Immutable;	// glNamedBufferStorage, can't be re-specified
 
 public:
+	// Static, immutable storage under the DSA backend so SetData doesn't apply
 	VertexBuffer(const void* data, unsigned int size);
+	VertexBuffer(unsigned int size);
 	~VertexBuffer();
 
+	// Only for buffers from the dynamic constructor, asserts on immutable storage
+	void SetData(const void* data, unsigned int size);
+
 	void Bind() const;
 	void Unbind() const;
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline unsigned int GetSize() const { return m_Size; }
+	inline bool IsImmutable() const { return m_Immutable; }
 };